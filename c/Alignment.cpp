@@ -1,7 +1,224 @@
 #define __Alignment_cpp__
 
+#include <cstring>
+
 #include "Alignment.h"
 
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+#define ALIGNMENT_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Anti-diagonal k of the dynamic programming table (\see Alignment::_align): cells ( i, k-i )
+ * 
+ * Arrays are indexed by row+1 (index 0: first row of the table, before the string in rows)
+ */
+struct AntiDiagonal {
+	const int32_t* S1; // anti-diagonal k-1
+	const int32_t* M1;
+	const int32_t* L1;
+	const int32_t* S2; // anti-diagonal k-2
+	const int32_t* M2;
+	const int32_t* L2;
+	int32_t* S;        // anti-diagonal k
+	int32_t* M;
+	int32_t* L;
+
+	const char* r;     // string in rows: row i at r[i]
+	const char* c;     // string in columns, reversed: column k-i at c[i]
+
+	int32_t ma;
+	int32_t mi;
+	int32_t ga;
+};
+
+/**
+ * Cell on row \param i of the anti-diagonal: the same as Alignment::match
+ */
+static inline void cell( const AntiDiagonal& a, LLength i, bool last_row, bool last_column ) {
+// 	W - horizontal gap, except on last row
+	int32_t S = a.S1[i+1];
+	int32_t M = a.M1[i+1];
+	int32_t L = a.L1[i+1];
+	if( !last_row ) { S += a.ga; L++; }
+
+// 	NW - match or mismatch
+	const bool m = a.r[i] & a.c[i];
+	const int32_t dS = a.S2[i] + ( m ? a.ma : a.mi );
+	if( S < dS ) { S = dS; M = a.M2[i] + m; L = a.L2[i] + 1; }
+
+// 	N - vertical gap (edge gaps are not counted)
+	const int32_t vS = a.S1[i] + a.ga;
+	if( S < vS ) { S = vS; M = a.M1[i]; L = a.L1[i] + !last_column; }
+
+	a.S[i+1] = S;
+	a.M[i+1] = M;
+	a.L[i+1] = L;
+}
+
+/**
+ * Cells on rows [\param i,\param hi) of the anti-diagonal (not on the last row or column), by vectors of cells
+ * 
+ * \returns the first row not computed (less than one vector left)
+ */
+static LLength cellsScalar( const AntiDiagonal&, LLength i, LLength ) {
+	return i;
+}
+
+#ifdef ALIGNMENT_X86
+__attribute__(( target( "sse4.1" ))) static LLength cellsSSE41( const AntiDiagonal& a, LLength i, LLength hi ) {
+	const __m128i one  = _mm_set1_epi32( 1 );
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ma   = _mm_set1_epi32( a.ma );
+	const __m128i mi   = _mm_set1_epi32( a.mi );
+	const __m128i ga   = _mm_set1_epi32( a.ga );
+
+	for( ; i + 4 <= hi ; i += 4 ) {
+		__m128i S = _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.S1+i+1 )), ga );
+		__m128i M = _mm_loadu_si128(( const __m128i* )( a.M1+i+1 ));
+		__m128i L = _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.L1+i+1 )), one );
+
+		int32_t r4, c4;
+		memcpy( &r4, a.r+i, 4 );
+		memcpy( &c4, a.c+i, 4 );
+		const __m128i mis = _mm_cmpeq_epi32( _mm_cvtepu8_epi32( _mm_cvtsi32_si128( r4 & c4 )), zero );
+
+		const __m128i dS = _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.S2+i )), _mm_blendv_epi8( ma, mi, mis ));
+		const __m128i dM = _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.M2+i )), _mm_andnot_si128( mis, one ));
+		const __m128i dL = _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.L2+i )), one );
+
+		__m128i t = _mm_cmpgt_epi32( dS, S );
+		S = _mm_blendv_epi8( S, dS, t );
+		M = _mm_blendv_epi8( M, dM, t );
+		L = _mm_blendv_epi8( L, dL, t );
+
+		const __m128i vS = _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.S1+i )), ga );
+		t = _mm_cmpgt_epi32( vS, S );
+		S = _mm_blendv_epi8( S, vS, t );
+		M = _mm_blendv_epi8( M, _mm_loadu_si128(( const __m128i* )( a.M1+i )), t );
+		L = _mm_blendv_epi8( L, _mm_add_epi32( _mm_loadu_si128(( const __m128i* )( a.L1+i )), one ), t );
+
+		_mm_storeu_si128(( __m128i* )( a.S+i+1 ), S );
+		_mm_storeu_si128(( __m128i* )( a.M+i+1 ), M );
+		_mm_storeu_si128(( __m128i* )( a.L+i+1 ), L );
+	}
+
+	return i;
+}
+
+__attribute__(( target( "avx2" ))) static LLength cellsAVX2( const AntiDiagonal& a, LLength i, LLength hi ) {
+	const __m256i one  = _mm256_set1_epi32( 1 );
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ma   = _mm256_set1_epi32( a.ma );
+	const __m256i mi   = _mm256_set1_epi32( a.mi );
+	const __m256i ga   = _mm256_set1_epi32( a.ga );
+
+	for( ; i + 8 <= hi ; i += 8 ) {
+		__m256i S = _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.S1+i+1 )), ga );
+		__m256i M = _mm256_loadu_si256(( const __m256i* )( a.M1+i+1 ));
+		__m256i L = _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.L1+i+1 )), one );
+
+		const __m128i rc = _mm_and_si128( _mm_loadl_epi64(( const __m128i* )( a.r+i )), _mm_loadl_epi64(( const __m128i* )( a.c+i )));
+		const __m256i mis = _mm256_cmpeq_epi32( _mm256_cvtepu8_epi32( rc ), zero );
+
+		const __m256i dS = _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.S2+i )), _mm256_blendv_epi8( ma, mi, mis ));
+		const __m256i dM = _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.M2+i )), _mm256_andnot_si256( mis, one ));
+		const __m256i dL = _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.L2+i )), one );
+
+		__m256i t = _mm256_cmpgt_epi32( dS, S );
+		S = _mm256_blendv_epi8( S, dS, t );
+		M = _mm256_blendv_epi8( M, dM, t );
+		L = _mm256_blendv_epi8( L, dL, t );
+
+		const __m256i vS = _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.S1+i )), ga );
+		t = _mm256_cmpgt_epi32( vS, S );
+		S = _mm256_blendv_epi8( S, vS, t );
+		M = _mm256_blendv_epi8( M, _mm256_loadu_si256(( const __m256i* )( a.M1+i )), t );
+		L = _mm256_blendv_epi8( L, _mm256_add_epi32( _mm256_loadu_si256(( const __m256i* )( a.L1+i )), one ), t );
+
+		_mm256_storeu_si256(( __m256i* )( a.S+i+1 ), S );
+		_mm256_storeu_si256(( __m256i* )( a.M+i+1 ), M );
+		_mm256_storeu_si256(( __m256i* )( a.L+i+1 ), L );
+	}
+
+	return i;
+}
+#endif
+
+/**
+ * Whether the match percentage of the alignment (the cell ending the path of the highest score) is less than
+ * \param least, after anti-diagonal \param k (rows [\param lo,\param hi); anti-diagonal k-1: rows
+ * [\param lo1,\param hi1))
+ * 
+ * The path of the result goes through a node on anti-diagonal k-1 or k (a diagonal step skips one): a
+ * cell, a node of the first row (where the path starts, with no score) or of the first column. From a
+ * node on row i, the R = lr-1-i rows left add at most R to the score (+1 for each match) and at most
+ * R matches; the percentage of the path is at most 100*(M+R)/(L+R). Any cell, followed by its diagonal
+ * (then the last column and the last row), makes a path of score at least S-R: the score of the result
+ * is at least the highest of these, sigma. Only the nodes with S+R >= sigma may be on the path of the
+ * result; nodes of the first row or column may reach 100%
+ * 
+ * NOTE: 100*(M+R)/(L+R) is computed like the percentage of the result (\see Match::onSequence): the
+ *       bound is not less than the percentage, ties included
+ */
+static bool hopeless( const AntiDiagonal& a, LLength k, LLength lo, LLength hi, LLength lo1, LLength hi1, LLength lc, LLength lr, double least ) {
+	const int32_t* S[2] = { a.S1, a.S };
+	const int32_t* M[2] = { a.M1, a.M };
+	const int32_t* L[2] = { a.L1, a.L };
+	const LLength rlo[2] = { lo1, lo };
+	const LLength rhi[2] = { hi1, hi };
+
+	long sigma = numeric_limits<long>::min();
+	for( unsigned int d = 0 ; d < 2 ; d++ ) {
+		for( LLength i = rlo[d] ; i < rhi[d] ; i++ ) {
+			sigma = max( sigma, long( S[d][i+1] ) - long( lr-1-i ));
+		}
+	}
+	if( sigma == numeric_limits<long>::min()) return false; // no cells
+
+// 	first row: paths starting on column k or after; at most one match per column left
+	const long first_row = 2*min( long( lr ), long( lc ) - 1 - long( k )) - long( lr );
+	if( first_row >= sigma ) return false;
+
+// 	first column: rows k and k+1 (anti-diagonals k-1 and k), score -(i+1)
+	for( LLength i = k ; ( i <= k+1 ) && ( i < lr ) ; i++ ) {
+		if( -long( i+1 ) + long( lr-1-i ) >= sigma ) return false;
+	}
+
+	for( unsigned int d = 0 ; d < 2 ; d++ ) {
+		for( LLength i = rlo[d] ; i < rhi[d] ; i++ ) {
+			const long R = lr-1-i;
+			if( long( S[d][i+1] ) + R < sigma ) continue; // not on the path of the result
+
+			const long m = M[d][i+1] + R;
+			const long l = L[d][i+1] + R;
+			if( !l || ( 100.0 * m / l >= least )) return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * \returns \param x / 2, rounded down (negative values too)
+ */
+static inline long half( long x ) {
+	return ( x >= 0 ) ? x / 2 : -(( 1 - x ) / 2 );
+}
+
+/**
+ * Widest vectors supported by the processor (checked once, at run time)
+ */
+static LLength ( *selectCells())( const AntiDiagonal&, LLength, LLength ) {
+#ifdef ALIGNMENT_X86
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports( "avx2" )) return cellsAVX2;
+	if( __builtin_cpu_supports( "sse4.1" )) return cellsSSE41;
+#endif
+	return cellsScalar;
+}
+
 void Alignment::init( const LLength co, const LLength ro ) {
 	for( LLength i = 0 ; i < ro ; i++ ) e.at( i ) = { int( i+1 ) * ga, 0 , 0 };
 }
@@ -11,9 +228,135 @@ void Alignment::init( const LLength co, const LLength ro ) {
  * 
  * \see Align::_align
  */
-Alignment::Element Alignment::align( const string& s1, const Position p1, const LLength l1, const string& s2, const Position p2, const LLength l2 ) {
-	if( l1 < l2 ) return _align( s2, p2, l2, s1, p1, l1 );
-	return _align( s1, p1, l1, s2, p2, l2 );
+Alignment::Element Alignment::align( const string& s1, const Position p1, const LLength l1, const string& s2, const Position p2, const LLength l2, const double least ) {
+	if( l1 < l2 ) return _align( s2, p2, l2, s1, p1, l1, least );
+	return _align( s1, p1, l1, s2, p2, l2, least );
+}
+
+/**
+ * Align the strings s1 and s2 within the band of diagonals [\param dlo,\param dhi]: the cells where the
+ * position in s1 minus the position in s2 is in the band (\see Alignment::_alignBand)
+ */
+Alignment::Element Alignment::align( const string& s1, const Position p1, const LLength l1, const string& s2, const Position p2, const LLength l2, long dlo, long dhi, const double least ) {
+	if( l1 < l2 ) return _alignBand( s2, p2, l2, s1, p1, l1, -dhi, -dlo, least );
+	return _alignBand( s1, p1, l1, s2, p2, l2, dlo, dhi, least );
+}
+
+/**
+ * Modified Needleman-Wunsch global alignment algorithm, by anti-diagonals (\see Alignment::_alignColumns)
+ */
+Alignment::Element Alignment::_align( const string& c, Position pc, LLength lc, const string& r, Position pr, LLength lr, const double least ) {
+	return _alignBand( c, pc, lc, r, pr, lr, -long( lr ), long( lc ), least );
+}
+
+/**
+ * Modified Needleman-Wunsch global alignment algorithm, by anti-diagonals, within the band of diagonals
+ * [\param dlo,\param dhi]: the cells ( i, j ) with column j - row i in the band
+ * 
+ * The cells of an anti-diagonal do not depend on each other: they are computed by vectors of 8 (AVX2)
+ * or 4 (SSE4.1) cells, depending on the processor; one cell at a time otherwise. Each cell makes the same
+ * choices as Alignment::match (ties included): with a band covering the whole table, the result is the same
+ * 
+ * Cells outside the band are never chosen. The path ends on the last cell of the band on the last row
+ * (skipping the rest of the longest string is free). Time is proportional to the area of the band;
+ * storage to the length of the shortest string
+ * 
+ * Every bound_period anti-diagonals, the alignment is abandoned if its match percentage cannot reach
+ * \param least (\see hopeless); the result is then an Element with L=0
+ */
+Alignment::Element Alignment::_alignBand( const string& c, Position pc, LLength lc, const string& r, Position pr, LLength lr, long dlo, long dhi, const double least ) {
+	assert( lc >= lr ); // more columns than rows!
+	assert( lr > 0 );
+
+// 	the band reaches the last row
+	dlo = max( min( dlo, long( lc ) - long( lr )), -long( lr ));
+	dhi = min( max( dhi, -long( lr-1 )), long( lc ));
+	if( dhi < dlo ) dhi = dlo;
+
+	const bool band = ( dlo > -long( lr )) || ( dhi < long( lc ) - 1 );
+	const int32_t outside = numeric_limits<int32_t>::min() / 2; // score of the cells outside the band
+
+	static LLength ( *const cells )( const AntiDiagonal&, LLength, LLength ) = selectCells();
+
+	rc.assign( lr, '\0' ); // NOTE: padding, so that AntiDiagonal::c stays within rc
+	rc.append( c.rend() - pc - lc, c.rend() - pc );
+
+	for( unsigned int d = 0 ; d < 3 ; d++ ) {
+		dS[d].resize( lr+1 );
+		dM[d].resize( lr+1 );
+		dL[d].resize( lr+1 );
+
+		dS[d][0] = dM[d][0] = dL[d][0] = 0; // first row: no gap penalties
+	}
+
+	dS[2][1] = ga; // first column, on anti-diagonal -1
+	dM[2][1] = dL[2][1] = 0;
+
+	Element result{ outside, 0, 0 }; // last cell computed on the last row
+
+	LLength lo1 = 0, hi1 = 0; // rows of the previous anti-diagonal
+
+	AntiDiagonal a;
+	a.r = r.data() + pr;
+	a.ma = ma;
+	a.mi = mi;
+	a.ga = ga;
+
+	for( LLength k = 0 ; k < lc + lr - 1 ; k++ ) { // foreach anti-diagonal
+		const unsigned int d = k % 3, d1 = ( k+2 ) % 3, d2 = ( k+1 ) % 3;
+
+		a.S1 = dS[d1].data(); a.M1 = dM[d1].data(); a.L1 = dL[d1].data();
+		a.S2 = dS[d2].data(); a.M2 = dM[d2].data(); a.L2 = dL[d2].data();
+		a.S  = dS[d].data();  a.M  = dM[d].data();  a.L  = dL[d].data();
+
+		LLength lo = ( k+1 > lc ) ? k+1 - lc : 0; // rows [lo,hi)
+		LLength hi = min( lr, k+1 );
+
+		if( band ) { // rows with k - 2*i in [dlo,dhi]
+			const long blo = half( long( k ) - dhi + 1 );
+			const long bhi = half( long( k ) - dlo ) + 1;
+
+			lo = LLength( min( max( long( lo ), blo ), long( hi )));
+			hi = LLength( max( min( long( hi ), bhi ), long( lo )));
+		}
+
+		a.c = rc.data() + lr + lc-1 - k; // NOTE: a.c[i] is only read for i >= lo
+
+		LLength i = lo;
+		if(( k+1 >= lc ) && ( lo == k+1 - lc ) && ( lo < hi )) cell( a, i++, lo == lr-1, true ); // last column
+
+		const LLength inner = ( hi == lr ) ? lr-1 : hi; // last row: no gap penalty
+		if( i < inner ) {
+			i = cells( a, i, inner );
+			for( ; i < inner ; i++ ) cell( a, i, false, false );
+		}
+
+		if(( hi == lr ) && ( i < lr )) cell( a, i, true, false ); // last row
+
+		if(( hi == lr ) && ( lo < hi )) result = { a.S[lr], LLength( a.M[lr] ), LLength( a.L[lr] )};
+
+		if(( least > 0 ) && ( k % bound_period == bound_period-1 ) && hopeless( a, k, lo, hi, lo1, hi1, lc, lr, least )) {
+			return Element{ outside, 0, 0 };
+		}
+		lo1 = lo;
+		hi1 = hi;
+
+		if( band ) { // the neighbours outside the band, read on the next anti-diagonal
+			if( lo >= 1 ) a.S[lo] = outside;
+			if( lo >= 2 ) a.S[lo-1] = outside;
+			if( hi < lr ) a.S[hi+1] = outside;
+			if( hi+1 < lr ) a.S[hi+2] = outside;
+		}
+
+		if( k+1 < lr ) { // first column, on row k+1
+			a.S[k+2] = int32_t( k+2 ) * ga;
+			a.M[k+2] = a.L[k+2] = 0;
+		}
+	}
+
+	assert( result.L > 0 ); // overlap length will be used to calculate the overlap percentage
+
+	return result;
 }
 
 /**
@@ -39,9 +382,11 @@ Alignment::Element Alignment::align( const string& s1, const Position p1, const
  *    ------
  *     L=6         M/L = 5 / 6 = 83.3%
  * 
+ * One column at a time, calling Alignment::match for each cell (\see AlignmentPrint)
+ * 
  * \see Alignment::Element
  */
-Alignment::Element Alignment::_align( const string& c, Position pc, LLength lc, const string& r, Position pr, LLength lr ) {
+Alignment::Element Alignment::_alignColumns( const string& c, Position pc, LLength lc, const string& r, Position pr, LLength lr ) {
 	assert( lc >= lr ); // more columns than rows!
 
 	if( lr >= max_length_smallest_sequence ) error( "both strings to align are longer than maximum length (", max_length_smallest_sequence, ")" );
@@ -10,6 +10,13 @@ void AlignmentPrint::init( const LLength co, const LLength ro ) {
 	for( LLength i = 0 ; i < ro ; i++ )  T.at( i+1 ).at( 0 ) = '|';
 }
 
+/**
+ * The traceback table needs every cell: one column at a time, never abandoned
+ */
+Alignment::Element AlignmentPrint::_align( const string& c, const Position pc, const LLength lc, const string& r, const Position pr, const LLength lr, const double ) {
+	return _alignColumns( c, pc, lc, r, pr, lr );
+}
+
 char AlignmentPrint::match( const LLength i, const LLength j,
 		const string& c, const Position pc, const LLength lc,
 		const string& r, const Position pr, const LLength lr,
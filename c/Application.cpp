@@ -9,6 +9,7 @@
 const string Application::version = "2.5.0.2"; // do not modify
 
 const int Application :: I_oligo_size_min = 12;
+const size_t Application :: output_batch = 1 << 22;
 const int Application :: I_oligo_size_max = 100;
 
 const string Application :: dash = "--";
@@ -74,6 +75,7 @@ Application :: Application( int iArgc, char* asArgv[] ) :
 		{ "max-crowded-ambiguities", -1 },
 		{ "first-site-gap", 5 },
 		{ "inter-site-gap", 5 },
+		{ "prefix-depth", int( Trie::default_depth )},
 		{ "threads",
 // 	the default number of threads is the "number of processors - 1" or "1" for single processor systems
 			max( thread::hardware_concurrency(), unsigned( 2 )) - 1
@@ -127,6 +129,10 @@ Application :: Application( int iArgc, char* asArgv[] ) :
 		{ "source", &onull },
 
 		{ "match-output", &cout },
+
+		{ "index-output", &onull },
+
+		{ "write-db", &onull },
 	}),
 
 // 	input
@@ -138,6 +144,8 @@ Application :: Application( int iArgc, char* asArgv[] ) :
 		{ "database", "" },
 		{ "taxonomy", "" },
 		{ "match", "" },
+		{ "index", "" },
+		{ "read-db", "" },
 	})
 
 // //	everything else is sequence files
@@ -302,8 +310,31 @@ void Application :: readArguments()
 
 // 	Argument tests go here
 
+	if( input.at( "index" ).size()) { // the index replaces the sequence files and all the processing before --match
+		if( sequence_files.size()) error( "incompatible options --index and sequence files" );
+		if( !input.at( "match" ).size()) error( "--index option, but no --match specified" );
+
+		for( const auto& e2in: input ) {
+			if(( e2in.first == "index" ) || ( e2in.first == "match" ) || !e2in.second.size()) continue;
+			error( "incompatible options --index and --"+e2in.first );
+		}
+
+		for( const auto& e2ou: output ) {
+			if(( e2ou.first == "help" ) || ( e2ou.first == "match-output" ) || ( e2ou.first == "time" ) || ( e2ou.second == &onull )) continue;
+			error( "incompatible options --index and --"+e2ou.first );
+		}
+
+		for( const auto& e2na: name_options ) {
+			error( "incompatible options --index and --"+e2na.first );
+		}
+
+		return;
+	}
+
 //	Whether any sequence files have been specified
-	if( !sequence_files.size())
+	if( input.at( "read-db" ).size()) { // the sequence database replaces the sequence files
+		if( sequence_files.size()) error( "incompatible options --read-db and sequence files" );
+	} else if( !sequence_files.size())
 		error( "no sequence files specified. Nothing to do." );
 
 	if( ranges.at( "oligo-size" ).first < 8 ) // issue #75
@@ -312,6 +343,18 @@ void Application :: readArguments()
 			" ** expecting at least 8"
 		);
 
+	if(( integers.at( "prefix-depth" ) < Trie::min_depth ) || ( integers.at( "prefix-depth" ) > Trie::max_depth ))
+		error(
+			"invalid value for --prefix-depth (", integers.at( "prefix-depth" ), ")\n",
+			" ** expecting integer value between ", int( Trie::min_depth ), " and ", int( Trie::max_depth )
+		);
+
+	if( integers.at( "prefix-depth" ) >= ranges.at( "oligo-size" ).first )
+		error(
+			"invalid value for --prefix-depth (", integers.at( "prefix-depth" ), ")\n",
+			" ** expecting value smaller than the minimum --oligo-size (", ranges.at( "oligo-size" ).first, ")"
+		);
+
 	if(( input.at( "taxonomy" ).size() > 0 ) && !input.at( "database" ).size()) // issue #74
 		error( "--taxonomy option, but no --database specified" );
 
@@ -380,6 +423,9 @@ void Application :: readArguments()
 	if(( floats["max-melting"] > -Thermo::K ) && flags["ambiguous-oligos"] )
 		error( "incompatible options --ambiguous-oligos and --max-melting" );
 
+	if(( output.at( "index-output" ) != &onull ) && flags.at( "ambiguous-oligos" ))
+		error( "incompatible options --ambiguous-oligos and --index-output" );
+
 	if(( floats["salt"] > 1.1 ) || ( floats["salt"] < 0.05 ))
 		error( "invalid value for option --salt (", floats["salt"], ")\n*** expecting value between 0.05 and 1.1" );
 
@@ -404,6 +450,23 @@ void Application :: readArguments()
 
 	if( !has_output )
 		error( "no output specified. Nothing to do." );
+
+// 	Whether the sequence database is the only output: no need to build the trie beyond the melting filter
+	b_database_only = ( output.at( "write-db" ) != &onull ) && !input.at( "match" ).size() && !name_options.count( "cladogram" ) && ( integers.at( "cluster-shape" ) <= 0 );
+	for( auto& o: output ){
+		if(( o.first == "write-db" ) || ( o.first == "help" ) || ( o.first == "time" ) || ( o.first == "match-output" )) continue;
+		if( o.second != &onull ) b_database_only = false;
+	}
+
+// 	Whether the oligo output files can be written by parts: no output needs all the matches at once (--metrics,
+// 	--cladogram, --cluster-shape), at most one output on stdout (the parts would interleave)
+	b_stream_output = ( output.at( "metrics" ) == &onull ) && !name_options.count( "cladogram" ) && ( integers.at( "cluster-shape" ) <= 0 );
+	int on_cout = 0;
+	for( auto& o: output ){
+		if(( o.first == "help" ) || ( o.first == "match-output" )) continue;
+		if( o.second == &cout ) on_cout++;
+	}
+	if( on_cout > 1 ) b_stream_output = false;
 }
 
 /**
@@ -427,9 +490,25 @@ int Application :: run()
 
 	timer.setOutput( output["time" ]);
 
-// 	Read input sequences
-	for( string& fn: sequence_files ){
-		source.parse( fn.c_str());
+	if( input.at( "index" ).size()) {
+// 	Here, will look up the target sequences in a previously built trie
+		TrieIndex index( input.at( "index" ));
+		Source indexed( index.getMinim(), index.getMaxim(), integers["max-ambiguities"], integers["max-crowded-ambiguities"], integers["max-homolo"] );
+		TrieMapped trie_mapped( indexed, index );
+		timer.check( "index" );
+
+		Match match( *output.at( "match-output" ), integers.at( "threads" ), trie_mapped, trie_mapped.minim );
+		match.parse( input.at( "match" ), integers.at( "threads" ));
+		timer.check( "match" );
+
+		return 0;
+	}
+
+// 	Read input sequences, or the sequence database written by a previous run (--write-db)
+	if( input.at( "read-db" ).size()) {
+		SourceDatabase::read( input.at( "read-db" ), source );
+	} else {
+		source.parseFiles( sequence_files, integers["threads"] );
 	}
 
 // 	Read phylogeny
@@ -444,12 +523,12 @@ int Application :: run()
 // 	Create trie, populate it, then print
 	if( flags["ambiguous-oligos"] ) {
 // 	Here, will create an ambiguous trie
-		TrieAmbig trie_ambig( source, ranges["oligo-size"].first, ranges["oligo-size"].second );
+		TrieAmbig trie_ambig( source, ranges["oligo-size"].first, ranges["oligo-size"].second, integers["prefix-depth"] );
 		return _run( trie_ambig );
 	}
 
 // 	Here, will create an unambiguous trie
-	Trie trie( source, ranges["oligo-size"].first, ranges["oligo-size"].second );
+	Trie trie( source, ranges["oligo-size"].first, ranges["oligo-size"].second, integers["prefix-depth"] );
 
 	return _run( trie );
 }
@@ -461,76 +540,115 @@ int Application :: run()
  */
 int Application::_run( Trie& trie )
 {
-	trie.buildSlices();
-	timer.check( "prepare" );
-
-	if(( floats["max-melting"] > -Thermo::K ) // filter on maximum melting temperature
-		|| ( output["fold"] != &onull )) {    // display the secondary structure and melting temperature
+// 	NOTE: the melting filter and the sequence database only depend on the Source, not on the slices
+	const bool melt =
+		( floats["max-melting"] > -Thermo::K ) // filter on maximum melting temperature
+		|| ( output["fold"] != &onull );       // display the secondary structure and melting temperature
+
+	Source::Melting melting;
+	if( trie.source.isMelted( melting )) { // the sequence database (--read-db) is already filtered
+		if( output["fold"] != &onull )
+			error( "incompatible options --fold and --read-db\n ** the sequence database (", input.at( "read-db" ), ") is already filtered for melting temperatures" );
+
+		if( !melt || !( melting == Source::Melting{ floats["max-melting"], floats["strand"], floats["salt"] }))
+			error(
+				"the sequence database (", input.at( "read-db" ), ") is filtered for melting temperatures with different options\n",
+				" ** expecting the same options ( --max-melting", melting.max_melting, "--strand", melting.strand_concentration, "--salt", melting.salt_concentration, ")"
+			);
+	} else if( melt ) {
 		trie.source.filterMelting( integers["threads"], floats["max-melting"], floats["strand"], floats["salt"]);
-		timer.check( "melt" );
+		check( trie, "melt" );
 	}
 
+	if( output.at( "write-db" ) != &onull ) {
+		SourceDatabase::write( *output.at( "write-db" ), trie.source );
+		check( trie, "database" );
+
+		if( b_database_only ) {
+			trie.source.printExcluded( "excluded.fasta" );
+			return 0;
+		}
+	}
+
+	trie.buildSlices();
+	check( trie, "prepare" );
+
 	trie.cover(integers["threads"]);
-	timer.check( "cover" );
+	check( trie, "cover" );
 
 	if( integers["max-homolo"]>0 ){
 		trie.filterHomolo( integers["threads"], integers["max-homolo"]);
-		timer.check( "homolo" );
+		check( trie, "homolo" );
 	}
 
 	trie.touch(integers["threads"]);
-	timer.check( "touch" );
+	check( trie, "touch" );
 
 	if( flags[ "ignore-snp" ]) {
 		trie.smallDiff( integers["threads"]);
-		timer.check( "snp" );
+		check( trie, "snp" );
 	}
 
-	trie.encodeClusters();
-	timer.check( "encode" );
-
-	trie.collectClusters(integers["threads"]);
-	timer.check( "clusters" );
+	trie.encodeClusters( integers["threads"]);
+	check( trie, "encode" );
 
 // 	Read taxonomy file
 	if( input["taxonomy"].size()) {
 		trie.source.parseTaxonomy( input["taxonomy"]);
-		timer.check( "taxonomy" );
+		check( trie, "taxonomy" );
 	}
 
 	if( input["database"].size()) {
 		Reference reference( trie, integers["threads"] );
-		reference.parse( input["database"]);
-		timer.check( "reference" );
+		reference.parse( input["database"], integers["threads"] );
+		check( trie, "reference" );
+	}
+
+	if( output.at( "index-output" ) != &onull ) {
+		TrieIndex::write( *output.at( "index-output" ), trie );
+		check( trie, "index" );
 	}
 
-	trie.collectMatches( integers["threads"]);
-	timer.check( "collect" );
+	if( !b_stream_output ) {
+		trie.collectMatches( integers["threads"]);
+		check( trie, "collect" );
 
-	trie.sortMatches(integers["threads"]);
-	timer.check( "sort" );
+		trie.sortMatches(integers["threads"]);
+		check( trie, "sort" );
+	}
 
 	trie.source.printExcluded( "excluded.fasta" );
 
 // 	Read matching file
 	if( input.at( "match" ).size()) {
 		Match match( *output.at( "match-output" ), integers.at( "threads" ), trie, ranges.at( "oligo-size" ).first );
-		match.parse( input.at( "match" ));
-		timer.check( "match" );
+		match.parse( input.at( "match" ), integers.at( "threads" ));
+		check( trie, "match" );
+	}
+
+	if( b_stream_output ) {
+		streamOutput( trie );
+		check( trie, "stream" );
+	} else {
+		OutputPart whole = wholeOutput( trie );
+
+		OligoRanges ra; // NOTE: calculated once for --positions and --ranges
+		if(( output["positions"] != &onull ) || ( output["ranges"] != &onull )) ra = calculateRanges( trie, whole );
+
+		printOligoStrings(    output["strings"          ], trie, whole );
+		printOligoPositions(  output["positions"        ], trie, ra );
+		printOligoRanges(     output["ranges"           ], trie, ra );
+		printFasta(           output["fasta"            ], trie, whole );
+		printGff(             output["gff"              ], trie, whole );
+		printTab(             output["tab"              ], trie, whole );
 	}
 
-	printOligoStrings(    output["strings"          ], trie );
-	printOligoPositions(  output["positions"        ], trie );
-	printOligoRanges(     output["ranges"           ], trie );
-	printFasta(           output["fasta"            ], trie );
-	printGff(             output["gff"              ], trie );
-	printTab(             output["tab"              ], trie );
 	printNewick(          output["newick"           ], trie );
 	printNodeList(        output["node-list"        ], trie );
 	printLineage(         output["lineage"          ], trie );
 
 	printClusterList(     output["cluster-list"     ], trie );
-	printClusterOligos(   output["cluster-oligos"   ], trie );
+	if( !b_stream_output ) printClusterOligos( output["cluster-oligos"], trie );
 	printSequenceClusters(output["sequence-clusters"], trie );
 
 	printMetrics( output["metrics"], trie );
@@ -541,33 +659,149 @@ int Application::_run( Trie& trie )
 	if( integers.at( "cluster-shape" ) > 0 ) printClusterShape( &cout, trie ); // EXPERIMENTAL
 
 // 	return value transfered to main
-	timer.check( "print" );
+	check( trie, "print" );
 
 	return 0;
 }
 
 /**
- * Print calculated oligo signatures as strings
+ * End of a processing phase: display the time (--time) and account for the storage of the main
+ * structures (--metrics)
  */
-void Application :: printOligoStrings( ostream* o, Trie& trie ) const
+void Application::check( Trie& trie, const string& phase )
 {
-	if( o == &onull ) return;
+	timer.check( phase );
 
-	for( auto& t: trie.source.getTargets()) {
-		*o << "------------------------" << endl;
-		*o << t.second << endl;
-		*o << "------------------------" << endl;
+	if( output.at( "metrics" ) == &onull ) return;
 
-		if( !trie.source.clusters.has( t.first )) {
-			continue;
+	MemoryBreakdown m;
+	trie.memory( m );
+
+	for( const auto& e2by: m ) {
+		if( memory_phase.count( e2by.first ) && ( e2by.second <= memory_peak.at( e2by.first ))) continue; // keep the first phase at the peak
+
+		memory_peak[ e2by.first ] = e2by.second;
+		memory_phase[ e2by.first ] = phase;
+	}
+}
+
+/**
+ * The whole oligo output: all the targets, with all their matches collected
+ */
+Application::OutputPart Application::wholeOutput( Trie& trie ) const
+{
+	return OutputPart{ trie.source.getTargets().begin(), trie.source.getTargets().end(), true, true, 1 };
+}
+
+/**
+ * Write the oligo output files (--strings, --positions, --ranges, --fasta, --gff, --tab, --cluster-oligos)
+ * by parts, as the matches are collected
+ * 
+ * Cluster ids are in the order of their sets of sequences, the same as the order of the targets.
+ * All the matches are collected in one pass over the Trie, grouped by cluster in a single array
+ * (8 bytes per match, no containers per cluster); the matches of consecutive clusters (at most
+ * output_batch, at least one cluster) are then sorted and written for the targets of these clusters,
+ * then released
+ * 
+ * NOTE: --positions and --ranges are accumulated over all parts and written at the end
+ */
+void Application::streamOutput( Trie& trie )
+{
+	const unsigned int threads = integers.at( "threads" );
+
+	const vector<size_t> counts = trie.countMatches( threads );
+	const auto& targets = trie.source.getTargets();
+
+	vector<PositionDepthLength> ma; // matches of all clusters, grouped by cluster id
+	vector<size_t> offsets;
+	trie.collectMatches( threads, counts, ma, offsets );
+
+	const bool oligo_ranges = ( output.at( "positions" ) != &onull ) || ( output.at( "ranges" ) != &onull );
+	OligoRanges ra;
+
+	OutputPart part{ targets.begin(), targets.begin(), true, false, 1 };
+
+	for( Cluster lo = 0 ; !part.last ; lo++ ) {
+		Cluster hi = lo;
+		for( size_t n = 0 ; ( hi < counts.size()) && (( hi == lo ) || ( n + counts.at( hi ) <= output_batch )) ; hi++ ) {
+			n += counts.at( hi );
 		}
 
-		auto cluster = trie.matches.find( trie.source.clusters.at( t.first ));
-		if( cluster == trie.matches.end()) {
-			continue;
+		part.last = ( hi >= counts.size());
+		part.target_hi = part.last ? targets.end() : targets.lower_bound( trie.source.clusters.at( hi ));
+
+		for( Cluster c = lo ; c < hi ; c++ ) {
+			if( offsets.at( c ) == offsets.at( c+1 )) continue; // no matches
+
+			trie.matches[c].assign( ma.begin() + offsets.at( c ), ma.begin() + offsets.at( c+1 ));
 		}
+		trie.sortMatches( threads );
+
+		printOligoStrings(    output["strings"          ], trie, part );
+		printFasta(           output["fasta"            ], trie, part );
+		printGff(             output["gff"              ], trie, part );
+		printTab(             output["tab"              ], trie, part );
+		printClusterOligos(   output["cluster-oligos"   ], trie );
+
+		if( oligo_ranges ) {
+			OligoRanges r = calculateRanges( trie, part );
+
+			for( auto& e2rf: r.first ) {
+				combineRanges( ra.first[ e2rf.first ], e2rf.second );
+			}
+			combineRanges( ra.second, r.second );
+		}
+
+		map<Cluster,vector<PositionDepthLength>>().swap( trie.matches );
+
+		part.first = false;
+		part.target_lo = part.target_hi;
+		lo = hi-1;
+	}
+
+	printOligoPositions(  output["positions"        ], trie, ra );
+	printOligoRanges(     output["ranges"           ], trie, ra );
+}
+
+/**
+ * Matches (sorted) of each target of \param part, in the order of the targets; nullptr for targets without matches
+ */
+vector<pair<const string*,const vector<PositionDepthLength>*>> Application::targetMatches( Trie& trie, const OutputPart& part ) const
+{
+	vector<pair<const string*,const vector<PositionDepthLength>*>> r;
+
+	for( auto t = part.target_lo ; t != part.target_hi ; ++t ) {
+		const vector<PositionDepthLength>* v = nullptr;
+
+		if( trie.source.clusters.has( t->first )) { // targets with no matches do not have clusters
+			auto m = trie.matches.find( trie.source.clusters.at( t->first ));
+			if( m != trie.matches.end()) v = &m->second;
+		}
+
+		r.emplace_back( &t->second, v );
+	}
+
+	return r;
+}
+
+/**
+ * Print calculated oligo signatures as strings
+ */
+void Application :: printOligoStrings( ostream* o, Trie& trie, const OutputPart& part ) const
+{
+	if( o == &onull ) return;
+
+	const auto tm = targetMatches( trie, part );
+	const PackedSequence& c = trie.source.getSource();
 
-		for( PositionDepthLength pdl: cluster->second ) {
+	printBlocks( *o, integers.at( "threads" ), tm.size(), [&]( size_t i, OutputBuffer& b ) {
+		b << "------------------------" << '\n';
+		b << *tm[i].first << '\n';
+		b << "------------------------" << '\n';
+
+		if( !tm[i].second ) return;
+
+		for( PositionDepthLength pdl: *tm[i].second ) {
 			Position p = pdlPosition( pdl );
 			Depth    d = pdlDepth( pdl );
 			Length   l = pdlLength( pdl );
@@ -576,23 +810,21 @@ void Application :: printOligoStrings( ostream* o, Trie& trie ) const
 				if(( x+d ) < trie.minim )
 					continue;
 
-				*o << trie.source.printableSubsequence( p-d, d+x );
-
-				*o << endl;
+				b.subsequence( c, p-d, d+x ) << '\n';
 			}
 		}
-	}
+	});
 }
 
 /**
  * Print calculated positions of oligo signatures
  */
-void Application :: printOligoPositions( ostream* out, Trie& trie ) const
+void Application :: printOligoPositions( ostream* out, Trie& trie, const OligoRanges& ra ) const
 {
 	if( out == &onull )
 		return;
 
-	const map<string, map<TypeFragment, Cover<Position>>>& ranges_by_target_fragment = calculateRanges( trie ).first;
+	const map<string, map<TypeFragment, Cover<Position>>>& ranges_by_target_fragment = ra.first;
 
 	*out <<
 		"Filename" << "\t" <<
@@ -630,12 +862,12 @@ void Application :: printOligoPositions( ostream* out, Trie& trie ) const
  * Print calculated ranges of oligo signatures
  */
 // TODO: Application :: printOligoRanges
-void Application :: printOligoRanges( ostream* out, Trie& trie ) const
+void Application :: printOligoRanges( ostream* out, Trie& trie, const OligoRanges& ra ) const
 {
 	if( out == &onull )
 		return;
 
-	map<TypeFragment, Cover<Position>> ranges_by_fragment = calculateRanges( trie ).second;
+	const map<TypeFragment, Cover<Position>>& ranges_by_fragment = ra.second;
 
 	for( const auto& e2rf : ranges_by_fragment ) {
 		Position start = trie.source.fragments.at( e2rf.first ).getRange().lo();
@@ -694,183 +926,270 @@ void Application :: printOligoRanges( ostream* out, Trie& trie ) const
  *   - map of sequence identifiers by Cover of ranges
  *       - used for --ranges : collect oligo ranges (between two base pairs) for each sequence (irrelevant of the target)
  * 
- * \see Range, Cover
+ * Only the targets of \param part; targets, then fragments, are processed in parallel
+ * 
+ * \see Range, Cover, mergeRanges
  */
-pair<map<string, map<TypeFragment, Cover<Position>>>,map<TypeFragment, Cover<Position>>> Application::calculateRanges( Trie& trie ) const
+Application::OligoRanges Application::calculateRanges( Trie& trie, const OutputPart& part ) const
 {
-	pair<map<string, map<TypeFragment, Cover<Position>>>,map<TypeFragment, Cover<Position>>> result;
+	const unsigned int threads = integers.at( "threads" );
+	const auto tm = targetMatches( trie, part );
 
-	for( const auto& e2ta: trie.source.getTargets()) {
-		if( !trie.source.clusters.has( e2ta.first )) continue; // targets with no matches do not have clusters
+// 	ranges of each target, by fragment: targets in parallel
+	vector<map<TypeFragment, Cover<Position>>> by_target( tm.size());
 
-		auto cluster = trie.matches.find( trie.source.clusters.at( e2ta.first ));
-		if( cluster == trie.matches.end()) {
-			continue;
-		}
+	parallelFor( threads, tm.size(), [&]( size_t i ) {
+		if( !tm[i].second ) return;
 
-		string ta = e2ta.second;
+		map<TypeFragment, vector<Range<Position>>> v;
 
-		for( PositionDepthLength pdl: cluster->second ) {
+		for( PositionDepthLength pdl: *tm[i].second ) {
 			Position p = pdlPosition( pdl );
 			Depth    d = pdlDepth( pdl );
 			Length   l = pdlLength( pdl );
 
-			TypeFragment f = trie.source.getFragmentAtPosition( p );
+			v[ trie.source.getFragmentAtPosition( p )].emplace_back( p-d, Position{d}+l );
+		}
+
+		for( auto& e2fv: v ) {
+			by_target[i].emplace( e2fv.first, mergeRanges( e2fv.second ));
+		}
+	});
 
-			Range<Position> r{ p-d, Position{d}+l };
+	OligoRanges result;
+
+	for( size_t i = 0 ; i < tm.size() ; i++ ) {
+		if( by_target[i].empty()) continue;
+
+		combineRanges( result.first[ *tm[i].first ], by_target[i] ); // NOTE: target names could repeat
+	}
 
-			result.first[ ta ][ f ].combineWithRange( r );
-			result.second[ f ].combineWithRange( r );
+// 	ranges of each fragment, over all targets: fragments in parallel
+	map<TypeFragment, vector<Range<Position>>> by_fragment;
+
+	for( const auto& e2rf: result.first ) {
+		for( const auto& e2fc: e2rf.second ) {
+			vector<Range<Position>>& v = by_fragment[ e2fc.first ];
+			v.insert( v.end(), e2fc.second.begin(), e2fc.second.end());
 		}
 	}
 
+	vector<pair<const TypeFragment,vector<Range<Position>>>*> fragments;
+	for( auto& e2fv: by_fragment ) {
+		fragments.push_back( &e2fv );
+		result.second[ e2fv.first ]; // filled below
+	}
+
+	parallelFor( threads, fragments.size(), [&]( size_t i ) {
+		Cover<Position> c = mergeRanges( fragments[i]->second );
+		result.second.at( fragments[i]->first ).swap( c ); // NOTE: the map does not change
+	});
+
 	return result;
 }
 
 /**
- * Print calculated oligos into a file in the FASTA format
+ * Cover of all the Ranges in \param v (sorted in place): the same as Cover::combineWithRange of all
+ * the Ranges, in any order, in linearithmic time
+ * 
+ * Overlapping Ranges are combined; adjacent Ranges are not
  */
-void Application::printFasta( ostream* out, Trie& trie ) const
+Cover<Position> Application::mergeRanges( vector<Range<Position>>& v )
 {
-	if( out == &onull ) return;
+	sort( v.begin(), v.end());
 
-	for( const auto& t: trie.source.getTargets() ){
-		if( !trie.source.clusters.has( t.first )) {
-			continue;
+	Cover<Position> c;
+
+	for( size_t i = 0 ; i < v.size() ; ) {
+		Range<Position> e = v[i++];
+
+		for( ; ( i < v.size()) && ( v[i].lo() < e.hi()) ; i++ ) {
+			e += v[i];
 		}
 
-		auto m = trie.matches.find( trie.source.clusters.at( t.first ));
+		c += e;
+	}
+
+	return c;
+}
 
-		if( m == trie.matches.end()){
+/**
+ * Combine the ranges by fragment of \param from into \param into (\see mergeRanges)
+ */
+void Application::combineRanges( map<TypeFragment, Cover<Position>>& into, map<TypeFragment, Cover<Position>>& from )
+{
+	for( auto& e2fc: from ) {
+		auto f = into.find( e2fc.first );
+
+		if( f == into.end()) {
+			into[ e2fc.first ].swap( e2fc.second );
 			continue;
 		}
 
-		for( const PositionDepthLength v: m->second ){
+		vector<Range<Position>> v( f->second.begin(), f->second.end());
+		v.insert( v.end(), e2fc.second.begin(), e2fc.second.end());
+
+		Cover<Position> c = mergeRanges( v );
+		f->second.swap( c );
+	}
+}
+
+/**
+ * Print calculated oligos into a file in the FASTA format
+ */
+void Application::printFasta( ostream* out, Trie& trie, const OutputPart& part ) const
+{
+	if( out == &onull ) return;
+
+	const auto tm = targetMatches( trie, part );
+	const PackedSequence& c = trie.source.getSource();
+
+	printBlocks( *out, integers.at( "threads" ), tm.size(), [&]( size_t i, OutputBuffer& b ) {
+		if( !tm[i].second ) return;
+
+		for( const PositionDepthLength v: *tm[i].second ){
 			const Position p = pdlPosition( v );
 			const Depth    d = pdlDepth( v );
 			const Length   l = pdlLength( v );
 
 			const TypeFragment fid = trie.source.getFragmentAtPosition( p );
-			const Fragment f = trie.source.fragments.at( fid );
+			const Fragment& f = trie.source.fragments.at( fid );
 			const Position s = f.getRange().lo();
 
 			for( Length x=1 ; x<=l ; x++ ){
 				if(( x+d ) < trie.minim )
 					continue;
 
-				*out
+				b
 					<< ">"
-					<< t.second
+					<< *tm[i].first
 					<< "-len" << (d+x) << "-(s"
 					<< (p-s-d)+1 << "e" << (p-s+x) << ")"
 					<< f.rcId()
-					<< endl;
+					<< '\n';
 
-				*out << trie.source.printableSubsequence( p-d, d+x ) << endl;
+				b.subsequence( c, p-d, d+x ) << '\n';
 			}
 		}
-	}
+	});
 }
 
 /**
  * Print calculated oligos into a file in the GFF format
  */
-void Application::printGff( ostream* out, Trie& trie ) const
+void Application::printGff( ostream* out, Trie& trie, OutputPart& part ) const
 {
 	if( out == &onull ) return;
 
-	*out << "##gff-version3" << endl;
+	if( part.first ) *out << "##gff-version3" << '\n';
 
-	unsigned long id = 1;
+	const auto tm = targetMatches( trie, part );
+	const PackedSequence& c = trie.source.getSource();
 
-	for( const auto& t: trie.source.getTargets() ){
-		if( !trie.source.clusters.has( t.first )) {
-			continue;
+// 	ids are consecutive across targets: the first id of each target is known before rendering
+	vector<unsigned long> first_id( tm.size()+1, part.gff_id );
+	for( size_t i = 0 ; i < tm.size() ; i++ ) {
+		unsigned long n = 0;
+
+		if( tm[i].second ) {
+			for( const PositionDepthLength v: *tm[i].second ){
+				const int lo = max( 1, int( trie.minim ) - int( pdlDepth( v ))); // first x with x+d >= minim
+				n += max( 0, int( pdlLength( v )) - lo + 1 );
+			}
 		}
 
-		auto m = trie.matches.find( trie.source.clusters.at( t.first ));
+		first_id[i+1] = first_id[i] + n;
+	}
+
+	printBlocks( *out, integers.at( "threads" ), tm.size(), [&]( size_t i, OutputBuffer& b ) {
+		if( !tm[i].second ) return;
 
-		if( m == trie.matches.end()){
-			continue;
-		}
+		unsigned long id = first_id[i];
 
-		for( const PositionDepthLength v: m->second ){
+		for( const PositionDepthLength v: *tm[i].second ){
 			const Position p = pdlPosition( v );
 			const Depth    d = pdlDepth( v );
 			const Length   l = pdlLength( v );
 
 			const TypeFragment fid = trie.source.getFragmentAtPosition( p );
-			const Fragment f = trie.source.fragments.at( fid );
+			const Fragment& f = trie.source.fragments.at( fid );
 			const Position s = f.getRange().lo();
 
 			for( Length x=1 ; x<=l ; x++ ){
 				if(( x+d ) < trie.minim )
 					continue;
 
-				*out
-					<< t.second
+				b
+					<< *tm[i].first
 					<< "\t.\t" << "len"
 					<< "\t" << (p-s-d)+1
 					<< "\t" << (p-s)+x
-					<< "\t.\t+\t.\tID=" << t.second << "-" << id++
+					<< "\t.\t+\t.\tID=" << *tm[i].first << "-" << id++
 					<< f.rcId()
-					<< ":" << trie.source.printableSubsequence( p-d, d+x ) << endl;
+					<< ":";
+				b.subsequence( c, p-d, d+x ) << '\n';
 			}
 		}
-	}
 
-	*out << "##FASTA" << endl;
+		assert( id == first_id[i+1] );
+	});
+
+	part.gff_id = first_id.back();
+
+	if( !part.last ) return;
+
+	*out << "##FASTA" << '\n';
 
+	vector<pair<const string*,Sequence>> se;
 	for( const auto& s: trie.source.instances.from ){
-		*out << ">" << s.first << endl;
-		for( auto i=trie.source.instance_fragments.from.equal_range( s.second ) ; i.first != i.second ; ++( i.first )) {
-			*out << trie.source.printableSubsequence( trie.source.fragments.at( i.first->second ).getRange()) << endl;
-		}
+		se.emplace_back( &s.first, s.second );
 	}
+
+	printBlocks( *out, integers.at( "threads" ), se.size(), [&]( size_t i, OutputBuffer& b ) {
+		b << ">" << *se[i].first << '\n';
+		for( auto j=trie.source.instance_fragments.from.equal_range( se[i].second ) ; j.first != j.second ; ++( j.first )) {
+			const Range<Position>& r = trie.source.fragments.at( j.first->second ).getRange();
+			b.subsequence( c, r.lo(), r.size()) << '\n';
+		}
+	});
 }
 
 /**
  * Print calculated oligos into a file in "tab" format
  */
-void Application::printTab( ostream* out, Trie& trie ) const
+void Application::printTab( ostream* out, Trie& trie, const OutputPart& part ) const
 {
 	if( out == &onull ) return;
 
-	for( const auto& t: trie.source.getTargets() ){
-		if( !trie.source.clusters.has( t.first )) {
-			continue;
-		}
-
-		auto m = trie.matches.find( trie.source.clusters.at( t.first ));
+	const auto tm = targetMatches( trie, part );
+	const PackedSequence& c = trie.source.getSource();
 
-		if( m == trie.matches.end()){
-			continue;
-		}
+	printBlocks( *out, integers.at( "threads" ), tm.size(), [&]( size_t i, OutputBuffer& b ) {
+		if( !tm[i].second ) return;
 
-		for( const PositionDepthLength v: m->second ){
+		for( const PositionDepthLength v: *tm[i].second ){
 			const Position p = pdlPosition( v );
 			const Depth    d = pdlDepth( v );
 			const Length   l = pdlLength( v );
 
 			const TypeFragment fid = trie.source.getFragmentAtPosition( p );
-			const Fragment f = trie.source.fragments.at( fid );
+			const Fragment& f = trie.source.fragments.at( fid );
 			const Position s = f.getRange().lo();
 
 			for( Length x=1 ; x<=l ; x++ ){
 				if(( x+d ) < trie.minim )
 					continue;
 
-				*out
-					<< t.second
+				b
+					<< *tm[i].first
 					<< "-len" << (d+x) << "-(s"
 					<< (p-s-d)+1 << "e" << (p-s+x) << ")"
 					<< f.rcId()
-					<< "\t"
-					<< trie.source.printableSubsequence( p-d, d+x )
-					<< endl;
+					<< "\t";
+				b.subsequence( c, p-d, d+x ) << '\n';
 			}
 		}
-	}
+	});
 }
 
 /**
@@ -1010,17 +1329,25 @@ void Application::printClusterList( ostream* out, Trie& trie ) const
  */
 void Application::printClusterOligos( ostream* out, Trie& trie ) const
 {
-	for( auto e2ma: trie.matches ) {
-		for( const PositionDepthLength& pdl: e2ma.second ) {
+	if( out == &onull ) return;
+
+	vector<const pair<const Cluster,vector<PositionDepthLength>>*> ma;
+	for( const auto& e2ma: trie.matches ) {
+		ma.push_back( &e2ma );
+	}
+
+	const PackedSequence& c = trie.source.getSource();
+
+	printBlocks( *out, integers.at( "threads" ), ma.size(), [&]( size_t i, OutputBuffer& b ) {
+		for( const PositionDepthLength& pdl: ma[i]->second ) {
 			Position p = pdlPosition( pdl );
 			Depth    d = pdlDepth( pdl );
 			Length   l = pdlLength( pdl );
 
-			*out
-				<< e2ma.first << '\t'
-				<< trie.source.printableSubsequence( p-d, d+l ) << endl;
+			b << ma[i]->first << '\t';
+			b.subsequence( c, p-d, d+l ) << '\n';
 		}
-	}
+	});
 }
 
 /**
@@ -1041,110 +1368,69 @@ void Application::printClusterOligos( ostream* out, Trie& trie ) const
 void Application::printSequenceClusters( ostream* out, Trie& trie ) const {
 	if( out == &onull ) return;
 
-	unordered_map<Sequence,set<Cluster>> seq2set_clu; // clusters containing sequence
-	unordered_map<Sequence,set<Cluster>> seq2set_clade; // signature clades containing sequence
+	const unsigned int threads = integers.at( "threads" );
 
-	for( const auto& e2in: trie.source.instances.from ) {
-		seq2set_clu.emplace( e2in.second, set<Cluster>{} );
-		seq2set_clade.emplace( e2in.second, set<Cluster>{} );
-	}
-
-	for( const auto& e2cl: trie.source.clusters.from ) {
-		for( const auto& se: e2cl.first ) {
-			seq2set_clu.at( se ).emplace( e2cl.second );
+	vector<pair<const string*,Sequence>> se; // sequences, in the order of their names
+	unordered_map<Sequence,size_t> seq2index;
 
-			if( !trie.source.targets.has( e2cl.first )) continue; // skip CLUSTERS that are not CLADES
-			seq2set_clade.at( se ).emplace( e2cl.second );
-		}
-	}
-
-	multimap<set<Cluster>, Sequence> set_clu2seq; // set of clusters containing a sequence
-	set<set<Cluster>> all_set_clu; // all possible combinations of clusters associated with each sequence
-
-	for( const auto e2ssc: seq2set_clu ) { // first:Sequence second:set<Cluster>
-		set_clu2seq.emplace( e2ssc.second, e2ssc.first );
-		all_set_clu.emplace( e2ssc.second );
-	}
-
-	multimap<set<Cluster>, Sequence> set_clade2seq; // set of signature clades containing a sequence
-	set<set<Cluster>> all_set_clade; // all possible combinations of signature clades associated with each sequence
-
-	for( const auto& e2ssn: seq2set_clade ) { // first:Sequence second:set<Cluster>
-		set_clade2seq.emplace( e2ssn.second, e2ssn.first );
-		all_set_clade.emplace( e2ssn.second );
+	for( const auto& e2in: trie.source.instances.from ) {
+		seq2index.emplace( e2in.second, se.size());
+		se.emplace_back( &e2in.first, e2in.second );
 	}
 
-	map<Sequence,set<Sequence>> cocluster; // for each sequence, the set of sequences "hidden" by the cluster pattern of the sequence:
-	                                       // sequences with cluster patterns included in the cluster pattern of the sequence
-	map<Sequence,set<Sequence>> coclade;   // for each sequence, the set of sequences "hidden" by the clade pattern of the sequence
-	                                       // sequences with clade patterns included in the cluster pattern of the sequence
-	
-	for( const auto& e2in: trie.source.instances.from ) { // for all sequences
-		const Sequence& se1 = e2in.second;
-		const set<Cluster>& sc1 = seq2set_clu.at( se1 );
-		const set<Cluster>& sn1 = seq2set_clade.at( se1 );
+	vector<vector<Cluster>> clu( se.size());   // clusters containing each sequence ("cluster pattern")
+	vector<vector<Cluster>> clade( se.size()); // signature clades containing each sequence ("clade pattern")
 
-		cocluster.emplace( se1, set<Sequence>{});
-		coclade.emplace( se1, set<Sequence>{});
-
-		for( const auto& e2ssc: seq2set_clu ) {
-			const Sequence& se2 = e2ssc.first;
-			const set<Cluster>& sc2 = e2ssc.second;
-
-			if( contains( sc1, sc2 )) cocluster.at( se1 ).emplace( se2 );
-		}
+	for( const auto& e2cl: trie.source.clusters.from ) {
+		const bool is_clade = trie.source.targets.has( e2cl.first ); // CLUSTERS that are CLADES
 
-		for( const auto& e2ssn: seq2set_clade ) {
-			const Sequence& se2 = e2ssn.first;
-			const set<Cluster>& sn2 = e2ssn.second;
+		for( const auto& s: e2cl.first ) {
+			const size_t i = seq2index.at( s );
 
-			if( contains( sn1, sn2 )) coclade.at( se1 ).emplace( se2 );
+			clu[i].push_back( e2cl.second );
+			if( is_clade ) clade[i].push_back( e2cl.second );
 		}
 	}
 
-// 	PRINT
-	for( const auto& e2in: trie.source.instances.from ) { // for each sequence
-		const string& name = e2in.first;
-		const Sequence& se = e2in.second;
+	parallelFor( threads, se.size(), [&]( size_t i ) {
+		sort( clu[i].begin(), clu[i].end());
+		sort( clade[i].begin(), clade[i].end());
+	});
 
-		*out << se << '\t'; // sequence identifier
-		*out << name << '\t'; // Sequence name
+// 	sequences with the same pattern; sequences "hidden" by the pattern of each sequence (with patterns included in it)
+	const ClusterPatterns pclu( clu, threads );
+	const ClusterPatterns pclade( clade, threads );
 
-		*out <<
-			set_clu2seq.count( // size of the set of Sequences with the same set of Clusters
-				seq2set_clu.at( se ) // set of Clusters containing the Sequence
-			) << '\t';
+// 	PRINT
+	printBlocks( *out, threads, se.size(), [&]( size_t i, OutputBuffer& b ) {
+		b << se[i].second << '\t'; // sequence identifier
+		b << *se[i].first << '\t'; // Sequence name
 
-		*out <<
-			set_clade2seq.count( // size of the set of Sequences with the same set of Nodes
-				seq2set_clade.at( se ) // set of signature clades containing the Sequence
-			) << '\t';
+		b << pclu.equal( i ) << '\t';   // size of the set of Sequences with the same set of Clusters
+		b << pclade.equal( i ) << '\t'; // size of the set of Sequences with the same set of signature clades
 
-		*out << cocluster.at( se ).size() << '\t';  // sequences hidden by the current sequence "cluster pattern"
-		*out << coclade.at( se ).size() << '\t'; // sequences hidden by the current sequence "clade pattern"
+		b << pclu.hidden( i ) << '\t';   // sequences hidden by the current sequence "cluster pattern"
+		b << pclade.hidden( i ) << '\t'; // sequences hidden by the current sequence "clade pattern"
 
 		bool first = true;
 //  - space-separated list of clusters containing the sequence ("cluster pattern")
-		for( const Cluster& cl: seq2set_clu.at( se )) { // PRINT space-separated list of clusters
-			if( first ) first = false; else *out << ' ';
-
-			*out << cl;
+		for( const Cluster& cl: clu[i] ) {
+			if( first ) first = false; else b << ' ';
+			b << cl;
 		}
-		*out << '\t';
+		b << '\t';
 
 		first = true;
-//  - space-separated list of signature clades containing the sequence ("clade pattern") 
-		for( const Cluster& cl: seq2set_clade.at( se )) { // PRINT space-separated list of targets (phylogeny-representative clusters)
-			if( first ) first = false; else *out << ' ';
-			*out << cl;
+//  - space-separated list of signature clades containing the sequence ("clade pattern")
+		for( const Cluster& cl: clade[i] ) {
+			if( first ) first = false; else b << ' ';
+			b << cl;
 		}
-		if( first ) *out << '-'; // "-" if there are no clade signatures
-		*out << '\t';
+		if( first ) b << '-'; // "-" if there are no clade signatures
+		b << '\t';
 
-
-
-		*out << endl;
-	}
+		b << '\n';
+	});
 }
 
 /**
@@ -1206,8 +1492,23 @@ void Application::printMetrics( ostream* out, Trie& trie )
 
 	*out << "=============prefixes==============" << endl;
 	for( const auto& ipr : prefix_distribution ) {
-		*out << convertNu2Asc( p42nu( Prefix4( ipr.first ))) << '\t' << ipr.second << endl;
+		*out << convertNu2Asc( pr2nu( Prefix( ipr.first ), trie.fixed_depth )) << '\t' << ipr.second << endl;
+	}
+
+	MemoryBreakdown memory;
+	trie.memory( memory );
+
+	*out << "=============memory================" << endl;
+	*out << "structure" << '\t' << "current" << '\t' << "peak" << '\t' << "phase" << endl;
+
+	size_t current = 0;
+	for( const auto& e2by: memory ) {
+		*out << e2by.first << '\t' << Bytes( e2by.second ) << '\t' << Bytes( memory_peak[ e2by.first ]) << '\t' << memory_phase[ e2by.first ] << endl;
+		current += e2by.second;
 	}
+
+	*out << "total" << '\t' << Bytes( current ) << endl;
+	*out << "resident" << '\t' << Bytes( Clock::resident()) << endl;
 }
 
 /**
@@ -2,8 +2,21 @@
 
 #include "Clock.h"
 
+#include <cstdio>
+
 const long Clock::ticks = sysconf(_SC_CLK_TCK);
 
+long long Clock::resident() {
+	FILE* f = fopen( "/proc/self/statm", "r" );
+	if( !f ) return 0;
+
+	long long size, pages;
+	const int n = fscanf( f, "%lld %lld", &size, &pages );
+	fclose( f );
+
+	return ( n == 2 ) ? pages * sysconf( _SC_PAGESIZE ) : 0;
+}
+
 /**
  * Print "maximum resident set size"
  * 
@@ -45,7 +58,12 @@ ostream& operator << ( ostream& o, Clock& c ) {
 
 	o << c.r << '\t';
 
+// 	current resident set size, and its change since the last check
+	const long long r = Clock::resident();
+	o << Bytes( r ) << '\t' << Bytes( r - c.r1, true ) << '\t';
+
 	c.e1 = e;
+	c.r1 = r;
 	c.u1 = u;
 	c.s1 = s;
 
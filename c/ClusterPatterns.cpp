@@ -0,0 +1,88 @@
+#define __ClusterPatterns_cpp__
+
+#include <atomic>
+#include <cstdint>
+
+#include "ClusterPatterns.h"
+#include "ThreadPool.h"
+
+ClusterPatterns::ClusterPatterns( const vector<vector<Cluster>>& patterns, unsigned int threads ) {
+// 	distinct patterns
+	map<vector<Cluster>,size_t> index;
+	vector<const vector<Cluster>*> d;
+
+	distinct.reserve( patterns.size());
+	for( const vector<Cluster>& p: patterns ) {
+		auto i = index.emplace( p, d.size());
+		if( i.second ) {
+			d.push_back( &i.first->first );
+			same.push_back( 0 );
+		}
+
+		distinct.push_back( i.first->second );
+		same.at( i.first->second )++;
+	}
+
+// 	candidates: distinct patterns by first cluster
+	size_t clusters = 0;
+	size_t empty = 0; // the empty pattern is included in all patterns
+	for( size_t q = 0 ; q < d.size() ; q++ ) {
+		if( d[q]->empty()) empty = same[q];
+		else clusters = max( clusters, size_t( d[q]->back()) + 1 );
+	}
+
+	vector<vector<size_t>> by_first( clusters );
+	for( size_t q = 0 ; q < d.size() ; q++ ) {
+		if( !d[q]->empty()) by_first[ d[q]->front()].push_back( q );
+	}
+
+// 	inclusion: each worker marks the clusters of the current pattern in its own bitset
+	included.assign( d.size(), 0 );
+	atomic<size_t> next( 0 );
+
+	parallel( unsigned( max( min( size_t( threads ), d.size()), size_t( 1 ))), [&]( unsigned int ) {
+		vector<uint64_t> bits(( clusters + 63 ) / 64, 0 );
+		auto has = [&bits]( Cluster c ) { return ( bits[ c/64 ] >> ( c%64 )) & 1; };
+
+		for( size_t p ; ( p = next++ ) < d.size() ; ) {
+			const vector<Cluster>& pa = *d[p];
+
+			for( Cluster c: pa ) bits[ c/64 ] |= uint64_t( 1 ) << ( c%64 );
+
+			size_t n = empty;
+			for( Cluster c: pa ) {
+				for( size_t q: by_first[c] ) {
+					const vector<Cluster>& qa = *d[q];
+					if( qa.size() > pa.size()) continue;
+
+					bool in = true;
+					for( size_t k = 1 ; in && ( k < qa.size()) ; k++ ) in = has( qa[k] );
+
+					if( in ) n += same[q];
+				}
+			}
+
+			included[p] = n;
+
+			for( Cluster c: pa ) bits[ c/64 ] = 0;
+		}
+	});
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
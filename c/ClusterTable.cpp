@@ -0,0 +1,105 @@
+#define __ClusterTable_cpp__
+
+#include <queue>
+#include <limits>
+
+#include "ClusterTable.h"
+
+Cluster ClusterTable::intern( const vector<Sequence>& l ) {
+	const size_t h = ListHash()( l );
+	const unsigned int k = unsigned( uint64_t( h ) >> ( 64 - shard_bits ));
+	Shard& sh = shard[k];
+
+	lock_guard<mutex> g( sh.lock );
+
+	auto i2id = sh.index.find( l );
+	if( i2id == sh.index.end()) {
+		if( sh.lists.size() >= ( numeric_limits<Cluster>::max() >> shard_bits )) {
+			error( "too many clusters" );
+		}
+
+		i2id = sh.index.emplace( l, Cluster( sh.lists.size())).first;
+		sh.lists.push_back( &i2id->first ); // NOTE: keys of an unordered_map do not move on rehash
+	}
+
+	return ( i2id->second << shard_bits ) | k;
+}
+
+void ClusterTable::rank( unsigned int threads, One2One<set<Sequence>,Cluster>& clusters ) {
+	assert( clusters.from.empty());
+
+// 	sort the lists of each shard
+	array<vector<Cluster>,shards> order; // indexes in lists, sorted by list
+	parallelFor( threads, shards, [this, &order]( size_t k ) {
+		const Shard& sh = shard[k];
+		vector<Cluster>& o = order[k];
+
+		o.resize( sh.lists.size());
+		for( Cluster i = 0 ; i < o.size() ; i++ ) o[i] = i;
+
+		::sort( o.begin(), o.end(), [&sh]( Cluster a, Cluster b ) { return *sh.lists[a] < *sh.lists[b]; });
+	});
+
+// 	merge the shards: the smallest list left gets the next id
+	array<size_t,shards> next;
+	next.fill( 0 );
+
+	auto head = [this, &order, &next]( unsigned int k ) -> const vector<Sequence>& {
+		return *shard[k].lists[ order[k][ next[k] ]];
+	};
+	auto later = [&head]( unsigned int a, unsigned int b ) { return head( b ) < head( a ); };
+
+	priority_queue<unsigned int,vector<unsigned int>,decltype( later )> heads( later );
+	for( unsigned int k = 0 ; k < shards ; k++ ) {
+		shard[k].ids.resize( shard[k].lists.size());
+		if( !order[k].empty()) heads.push( k );
+	}
+
+	Cluster id = 0;
+	while( !heads.empty()) {
+		const unsigned int k = heads.top();
+		heads.pop();
+
+		const vector<Sequence>& l = head( k );
+		shard[k].ids[ order[k][ next[k] ]] = id;
+
+// 	ids are increasing and lists are in order: always insert at the end
+		const set<Sequence> s( l.begin(), l.end());
+		clusters.from.emplace_hint( clusters.from.end(), s, id );
+		clusters.to.emplace_hint( clusters.to.end(), id, s );
+		id++;
+
+// 	NOTE: the head of shard k changes only while it is out of the queue
+		if( ++next[k] < order[k].size()) {
+			heads.push( k );
+		} else {
+			vector<Cluster>().swap( order[k] );
+		}
+	}
+}
+
+void ClusterTable::clear() {
+	for( Shard& sh: shard ) {
+		unordered_map<vector<Sequence>,Cluster,ListHash>().swap( sh.index );
+		vector<const vector<Sequence>*>().swap( sh.lists );
+		vector<Cluster>().swap( sh.ids );
+	}
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
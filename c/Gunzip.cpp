@@ -0,0 +1,332 @@
+#define __Gunzip_cpp__
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <unistd.h>
+#include <zlib.h>
+
+#include "Gunzip.h"
+
+#include "util.h"
+#include "Error.h"
+
+/**
+ * Bounded queue of decompressed blocks, between the reader thread and the consumer
+ */
+class BlockQueue {
+private:
+	mutex lock;
+	condition_variable changed;
+
+	deque<vector<char>> blocks;
+	const size_t capacity;
+
+	bool done = false;      // the reader has finished (no more blocks)
+	bool cancelled = false; // the consumer has stopped
+	exception_ptr failure;  // error in the reader
+
+public:
+	BlockQueue( size_t c ): capacity( c ) {};
+
+	/**
+	 * Add a block (reader); waits while the queue is full
+	 * 
+	 * \returns false if the consumer has stopped: the reader should stop too
+	 */
+	bool push( vector<char>&& b ) {
+		unique_lock<mutex> g( lock );
+		changed.wait( g, [this]() { return cancelled || ( blocks.size() < capacity ); });
+		if( cancelled ) return false;
+
+		blocks.push_back( move( b ));
+		changed.notify_all();
+		return true;
+	};
+
+	/**
+	 * Take the next block (consumer); waits while the queue is empty
+	 * 
+	 * \returns false after the last block; re-throws the error of the reader, if any
+	 */
+	bool pop( vector<char>& b ) {
+		unique_lock<mutex> g( lock );
+		changed.wait( g, [this]() { return done || !blocks.empty(); });
+
+		if( blocks.empty()) {
+			if( failure ) rethrow_exception( failure );
+			return false;
+		}
+
+		b = move( blocks.front());
+		blocks.pop_front();
+		changed.notify_all();
+		return true;
+	};
+
+	/**
+	 * No more blocks (reader), possibly because of \param e
+	 */
+	void finish( exception_ptr e = nullptr ) {
+		lock_guard<mutex> g( lock );
+		done = true;
+		failure = e;
+		changed.notify_all();
+	};
+
+	/**
+	 * Stop the reader (consumer)
+	 */
+	void cancel() {
+		lock_guard<mutex> g( lock );
+		cancelled = true;
+		changed.notify_all();
+	};
+};
+
+static const size_t chunk_size = 1 << 20; // decompressed blocks of the sequential reader
+static const size_t queue_blocks = 64;    // blocks waiting for the consumer
+
+/**
+ * Run \param produce in a reader thread and pass the blocks it makes, in order, to \param sink
+ */
+static void pipeline( const function<void( BlockQueue& )>& produce, const Gunzip::Sink& sink ) {
+	BlockQueue queue( queue_blocks );
+
+	thread reader( [&queue, &produce]() {
+		try {
+			produce( queue );
+			queue.finish();
+		} catch( ... ) {
+			queue.finish( current_exception());
+		}
+	});
+
+	try {
+		vector<char> b;
+		while( queue.pop( b )) {
+			sink( b.data(), b.size());
+		}
+	} catch( ... ) {
+		queue.cancel();
+		reader.join();
+		throw;
+	}
+
+	reader.join();
+}
+
+/**
+ * Sequential decompression of (one or more concatenated) gzip members
+ * 
+ * \param next provides the next piece of input; returns false at the end of the input
+ */
+static void inflateStream( const string& path, const function<bool( const char*&, size_t& )>& next, BlockQueue& queue ) {
+	z_stream z;
+	memset( &z, 0, sizeof( z ));
+	if( inflateInit2( &z, 15+16 ) != Z_OK ) error( "cannot decompress sequence file ( ", path, " )" ); // gzip header only
+
+	vector<char> out( chunk_size );
+	z.next_out = reinterpret_cast<Bytef*>( out.data());
+	z.avail_out = out.size();
+
+	bool member = true; // inside a gzip member
+	int r = Z_OK;
+
+	while( true ) {
+		if( !z.avail_in ) {
+			const char* p;
+			size_t n;
+			if( !next( p, n )) break;
+			if( !n ) continue;
+
+			z.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( p ));
+			z.avail_in = n;
+		}
+
+		if( !member ) { // NOTE: concatenated members (e.g. BGZF read sequentially)
+			inflateReset( &z );
+			member = true;
+		}
+
+		r = inflate( &z, Z_NO_FLUSH );
+		if(( r != Z_OK ) && ( r != Z_STREAM_END ) && ( r != Z_BUF_ERROR )) {
+			inflateEnd( &z );
+			error( "corrupt compressed sequence file ( ", path, " )" );
+		}
+
+		if( r == Z_STREAM_END ) member = false;
+
+		if( !z.avail_out ) {
+			out.resize( out.size() - z.avail_out );
+			if( !queue.push( move( out ))) { // NOTE: the consumer has failed; its error is reported (not this one)
+				inflateEnd( &z );
+				return;
+			}
+
+			out = vector<char>( chunk_size );
+			z.next_out = reinterpret_cast<Bytef*>( out.data());
+			z.avail_out = out.size();
+		}
+	}
+
+	inflateEnd( &z );
+
+	if( member ) error( "truncated compressed sequence file ( ", path, " )" );
+
+	out.resize( out.size() - z.avail_out );
+	if( !out.empty()) queue.push( move( out ));
+}
+
+/**
+ * Little endian integers of the gzip format
+ */
+static inline unsigned int le16( const char* p ) {
+	return unsigned( uint8_t( p[0] )) | ( unsigned( uint8_t( p[1] )) << 8 );
+}
+static inline uint32_t le32( const char* p ) {
+	return uint32_t( le16( p )) | ( uint32_t( le16( p+2 )) << 16 );
+}
+
+/**
+ * Decompress one BGZF block of \param n bytes at \param p into \param out
+ */
+static void inflateBlock( const string& path, const char* p, size_t n, vector<char>& out ) {
+	const size_t header = 12 + le16( p+10 ); // fixed header and extra field
+	if( n < header + 8 ) error( "corrupt compressed sequence file ( ", path, " )" );
+
+	const uint32_t crc = le32( p+n-8 );
+	out.resize( le32( p+n-4 ));
+
+	z_stream z;
+	memset( &z, 0, sizeof( z ));
+	if( inflateInit2( &z, -15 ) != Z_OK ) error( "cannot decompress sequence file ( ", path, " )" ); // raw deflate data
+
+	z.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( p+header ));
+	z.avail_in = n - header - 8;
+	Bytef empty; // NOTE: zlib rejects a null output buffer, even when empty (e.g. the end-of-file marker block)
+	z.next_out = out.empty() ? &empty : reinterpret_cast<Bytef*>( out.data());
+	z.avail_out = out.size();
+
+	const int r = inflate( &z, Z_FINISH );
+	const bool ok = ( r == Z_STREAM_END ) && !z.avail_out;
+	inflateEnd( &z );
+
+	if( !ok || ( crc32( crc32( 0, Z_NULL, 0 ), reinterpret_cast<const Bytef*>( out.data()), out.size()) != crc )) {
+		error( "corrupt compressed sequence file ( ", path, " )" );
+	}
+}
+
+bool Gunzip::isGzip( const char* p, size_t n ) {
+	return ( n >= 2 ) && ( uint8_t( p[0] ) == 0x1f ) && ( uint8_t( p[1] ) == 0x8b );
+}
+
+size_t Gunzip::bgzfBlock( const char* p, size_t n ) {
+	if(( n < 18 ) || !isGzip( p, n ) || ( p[2] != 8 ) || !( p[3] & 4 )) return 0; // deflate, with extra field
+
+	const size_t xlen = le16( p+10 );
+	if( n < 12 + xlen ) return 0;
+
+	for( size_t i = 12 ; i+4 <= 12+xlen ; i += 4 + le16( p+i+2 )) { // extra subfields
+		if(( p[i] == 'B' ) && ( p[i+1] == 'C' ) && ( le16( p+i+2 ) == 2 )) {
+			return le16( p+i+4 ) + 1;
+		}
+	}
+
+	return 0;
+}
+
+void Gunzip::memory( const string& path, const char* data, size_t n, unsigned int threads, const Sink& sink ) {
+	if( !bgzfBlock( data, n )) { // plain gzip: sequential
+		pipeline( [&path, data, n]( BlockQueue& queue ) {
+			bool first = true;
+			inflateStream( path, [data, n, &first]( const char*& p, size_t& k ) {
+				if( !first ) return false;
+
+				first = false;
+				p = data;
+				k = n;
+				return true;
+			}, queue );
+		}, sink );
+
+		return;
+	}
+
+// 	BGZF: batches of blocks are decompressed in parallel
+	const size_t batch_blocks = 16 * max( threads, 1U ); // NOTE: BGZF blocks are at most 64 KiB
+
+	pipeline( [&path, data, n, threads, batch_blocks]( BlockQueue& queue ) {
+		size_t o = 0;
+
+		while( o < n ) {
+			vector<pair<size_t,size_t>> batch; // offset and size of blocks
+			while(( o < n ) && ( batch.size() < batch_blocks )) {
+				const size_t b = bgzfBlock( data+o, n-o );
+				if( !b || ( b > n-o )) error( "corrupt or truncated BGZF sequence file ( ", path, " )" );
+
+				batch.emplace_back( o, b );
+				o += b;
+			}
+
+			vector<vector<char>> out( batch.size());
+			parallelFor( threads, batch.size(), [&]( size_t i ) { // NOTE: the reader takes part (\see ThreadPool::run)
+				inflateBlock( path, data + batch[i].first, batch[i].second, out[i] );
+			});
+
+			for( vector<char>& b: out ) {
+				if( b.empty()) continue; // e.g. the end-of-file marker block
+				if( !queue.push( move( b ))) return;
+			}
+		}
+	}, sink );
+}
+
+void Gunzip::stream( const string& path, const char* head, size_t n, int fd, const Sink& sink ) {
+	pipeline( [&path, head, n, fd]( BlockQueue& queue ) {
+		bool first = true;
+		vector<char> block( chunk_size );
+
+		inflateStream( path, [head, n, fd, &first, &block, &path]( const char*& p, size_t& k ) {
+			if( first ) {
+				first = false;
+				p = head;
+				k = n;
+				return true;
+			}
+
+			ssize_t r;
+			while((( r = read( fd, block.data(), block.size())) < 0 ) && ( errno == EINTR ));
+			if( r < 0 ) error( "cannot read sequence file ( ", path, " )" );
+
+			p = block.data();
+			k = r;
+			return r > 0;
+		}, queue );
+	}, sink );
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -2,75 +2,133 @@
 
 #include "Match.h"
 
+void Match::parse( const string& path, unsigned int thr ) {
+	parallel( threads, [&]( unsigned int w ) { // worker 0 (the calling thread): the parser, then a classifier; the others: classifiers
+		try {
+			Alignment al;
+
+			if( !w ) {
+				ParserFasta::parse( path, thr ); // NOTE: classifies queries too, when the pipeline is full (\see onFragment)
+				stop( false );
+			}
+
+			classifierLoop( w ? al : parser_alignment );
+		} catch( ... ) {
+			stop( true ); // NOTE: the pool re-throws the exception when all workers are done
+			throw;
+		}
+	});
+}
+
+/**
+ * The end of the pipeline: no more queries (\param failed: false), or stop all workers (\param failed: true)
+ */
+void Match::stop( bool failed ) {
+	{
+		lock_guard<mutex> g( lock );
+		b_closed = true;
+		b_failed = b_failed || failed;
+	}
+	wake_classifiers.notify_all();
+	wake_parser.notify_all();
+}
+
 void Match::onFragment( const string& na, const string& fn, const Cover<Position>& amb, const bool rc ){
-	match_sequences.emplace_back( na, amb );
+	const Range<Position>& ra = amb.range();
 
-	if( match_sequences.size() >= match_buffer_size ) processFragments();
-};
+	Query q;
+	q.na = na;
+	q.s = content.substr( ra.lo(), ra.size());
 
-void Match::onFinish() {
-	this->ParserFasta::onFinish();
-	processFragments();
-}
+	set<Range<Position>> se; // the ambiguous ranges, relative to the query
+	for( const Range<Position>& r: amb ) {
+		se.emplace( r.lo() - ra.lo(), r.size());
+	}
+	q.amb = Cover<Position>( Range<Position>( 0, ra.size()), se );
+
+// 	NOTE: the parser needs the content of the fragment until its reverse complement is read (\see ParserFasta::_onFragment)
+	if( rc || !isReverseComplement()) content.clear();
+
+	unique_lock<mutex> g( lock );
+
+	while( !b_failed && ( next_query - next_result >= match_buffer_size )) { // the pipeline is full
+		if( queries.empty()) {
+			wake_parser.wait( g );
+			continue;
+		}
+
+// 	queries are waiting for a classifier: the parser classifies one, rather than waiting
+		const Query h = move( queries.front());
+		queries.pop_front();
+
+		g.unlock();
+		classify( h, parser_alignment );
+		g.lock();
+	}
+	if( b_failed ) return; // NOTE: the exception of the failed worker is re-thrown by the pool
+
+	q.index = next_query++;
+	queries.push_back( move( q ));
+
+	g.unlock();
+	wake_classifiers.notify_one();
+};
 
 /**
- * Process a number of fragments read by the parser.
- * 
- * This can happen when match_buffer_size fragments have been read or at EOF input
+ * Worker function of a classifier: classify queries from the queue until the end of the queries, with \param al
  */
-void Match::processFragments() {
-	const ios_base::fmtflags floatflag = out.setf( ios::fixed, ios::floatfield ); // remember + set float fixed
-	const unsigned int prec = out.precision( 1 );  // remember + set precision to 99.1
+void Match::classifierLoop( Alignment& al ) {
+	while( true ) {
+		unique_lock<mutex> g( lock );
+		wake_classifiers.wait( g, [this]{ return b_closed || !queries.empty(); });
 
-	spin( threads, *this, &Match::sequenceLoop ); // start a number of worker threads and wait until they finish
+		if( b_failed || queries.empty()) return;
 
-// restore float and precision
-	out.setf( floatflag, ios::floatfield );
-	out.precision( prec );
+		const Query q = move( queries.front());
+		queries.pop_front();
 
-	match_sequences.clear();
-	content.clear(); // forget/reuse the storage for the current reference sequence
+		g.unlock();
+		classify( q, al );
+	}
 }
 
 /**
- * Worker function for processing sequences in a loop
+ * Classify query \param q, then write its result lines after the results of all earlier queries
  * 
- * Can be executed and synchronized between multiple threads
+ * Results that are not next in line wait in the reorder buffer: the one completing the next query writes
+ * all consecutive results available
  */
-void Match::sequenceLoop( bool& first ) {
-	static mutex lock; // initialization lock
+void Match::classify( const Query& q, Alignment& al ) {
+	ostringstream lines;
+	lines.setf( ios::fixed, ios::floatfield );
+	lines.precision( 1 ); // 99.1
 
-	static atomic<unsigned int> i( 0 ); // progress counter
-	const unsigned int n = match_sequences.size();
+	onSequence( lines, q, al );
 
-	Alignment al;
+	lock_guard<mutex> g( lock );
+	results.emplace( q.index, lines.str());
 
-	lock.lock();
-	if( first ) { // initialization
-		first = false;
-		i = 0;
+	for( auto it = results.begin() ; ( it != results.end()) && ( it->first == next_result ) ; it = results.erase( it )) {
+		out << it->second;
+		next_result++;
 	}
-	lock.unlock();
 
-	while( true ) { // sequence loop
-		const unsigned int ii = i++; // WARNING: will go over n in multiple threads
-		if( ii >= n ) break;
-		const auto& pa = match_sequences.at( ii );
-		onSequence( pa.first, pa.second, al ); // call the worker for each sequence
-	}
+	wake_parser.notify_one();
 }
 
 /**
  * Callback for processing a sequence from the input
  * 
- * Writes to output one line associated with the sequence
+ * Writes to \param out the lines associated with the sequence
  * 
- * \param na FASTA name of the sequence
- * \param amb ambiguous Cover of the sequence
+ * \param q the sequence: FASTA name, content and ambiguous Cover
  * 
  * \see Cover
  */
-void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment& al ) {
+void Match::onSequence( ostream& out, const Query& q, Alignment& al ) {
+	const string& na = q.na;
+	const Cover<Position>& amb = q.amb;
+
 	const LLength target_sequence_length = amb.range().size();
 
 	const double min_cluster_area_ratio = 0.75; // ignore target sequences with less area explained by clusters
@@ -80,7 +138,7 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 
 	const double size_factor = 2.0; // multiplier for the signature size vs. minimum target sequence length
 
-	set<Sequence> max_set;
+	SequenceSet max_set( sequences );
 
 	if( target_sequence_length < size_factor * le ) { // ignore short sequences
 		print( out,
@@ -92,12 +150,6 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 		return;
 	}
 
-	if( target_sequence_length >= Alignment::max_length_smallest_sequence )
-		error(
-			"target sequence too long (", na, "): ",
-			target_sequence_length, " >= ", Alignment::max_length_smallest_sequence
-		);
-
 // 	(1) Calculate list of clusters matching the sequence
 	set<Cluster> set_clusters;
 	deque<pair<Position,Cluster>> po_cluster;
@@ -108,7 +160,7 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 	for( const Range<Position>& ra: -amb ) { // O(1)
 		for( Position p = ra.lo() ; Length l = ra.cover( p, le, le ) ; p++ ) { // O(s) for each cluster matching the target sequence
 			Cluster clu( Cluster_invalid );
-			if( !trie.getCluster( content, p, l, clu )) continue; // next if there is no cluster at the current position
+			if( !trie.getCluster( q.s, p, l, clu )) continue; // next if there is no cluster at the current position
 
 			assert( clu != Cluster_invalid );
 
@@ -117,9 +169,8 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 			last_position = p + l;
 			cluster_area += l;
 
-			if( !contains( set_clusters, clu )) max_set += trie.source.clusters.at( clu );
+			if( set_clusters.emplace( clu ).second ) max_set += cluster_sequences.at( clu );
 
-			set_clusters.emplace( clu );
 			po_cluster.emplace_back( p, clu );
 
 		}
@@ -136,27 +187,22 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 	}
 
 // 	(2) build the minimum set of sequences
-	struct ClusterSizeCompare{
-		bool operator() ( const Cluster& c1, const Cluster& c2 ) const {
-			const size_t s1 = clusters.at( c1 ).size();
-			const size_t s2 = clusters.at( c2 ).size();
 
-			if( s1 < s2 ) return true;
-			if( s1 > s2 ) return false;
+// 	clusters sorted by size
+	vector<Cluster> sorted_clusters( set_clusters.begin(), set_clusters.end());
+	sort( sorted_clusters.begin(), sorted_clusters.end(), [this]( Cluster c1, Cluster c2 ) {
+		const size_t s1 = cluster_sequences[ c1 ].size();
+		const size_t s2 = cluster_sequences[ c2 ].size();
 
-			return ( c1 < c2 );
-		}
-		ClusterSizeCompare( const One2One<set<Sequence>,Cluster>& clus ) : clusters( clus ) {};
-		const One2One<set<Sequence>,Cluster>& clusters;
-	} clusterSizeCompare( trie.source.clusters );
+		return ( s1 < s2 ) || (( s1 == s2 ) && ( c1 < c2 ));
+	});
 
-// 	set of clusters sorted by size
-	set<Cluster,ClusterSizeCompare> sorted_clusters( set_clusters.begin(), set_clusters.end(), clusterSizeCompare );
-	set<Sequence> min_set;
+	SequenceSet min_set( sequences );
+	SequenceBitmap s1, s2;
 
 	for( Cluster cl1 : sorted_clusters ) {
-		set<Sequence> s1 = trie.source.clusters.at( cl1 );
-		if(!( min_set & s1 ).empty()) continue;
+		if( min_set.intersects( cluster_sequences[ cl1 ])) continue;
+		s1 = cluster_sequences[ cl1 ];
 
 		last_position = 0;
 		cluster_area = 0;
@@ -165,8 +211,7 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 			const Position& p = e2pocl.first;
 			const Cluster& cl2 = e2pocl.second;
 
-			set<Sequence> s2 = trie.source.clusters.at( cl2 );
-			s2 &= s1;
+			s2.intersect( s1, cluster_sequences[ cl2 ]);
 
 			if( s2.empty()) continue; // the current cluster has no overlap with the minimum cluster
 
@@ -183,7 +228,7 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 		min_set += s1;
 	}
 
-	if( !min_set.size()) { // skip target sequences with too many positions unexplained by any cluster
+	if( min_set.empty()) { // skip target sequences with too many positions unexplained by any cluster
 		print( out,
 			na, "",
 			100. * min_cluster_area_ratio, target_sequence_length,
@@ -195,43 +240,200 @@ void Match::onSequence( const string& na, const Cover<Position>& amb, Alignment&
 
 
 // 	(3) Align the target sequence to [all fragments of] sequences of the minumum set
-	deque<pair<Sequence,pair<double,LLength>>> aligned_sequences; // sequence by match percentage and overlap length
+//
+// 	NOTE: the candidates are aligned by decreasing number of oligos of the target sequence in their clusters;
+// 	      an alignment is abandoned as soon as it cannot reach the best match percentage so far (\see
+// 	      Alignment::_alignBand). Ties are kept: the result is the same as with all the alignments
+	struct Candidate {
+		Sequence se;
+		TypeFragment fra;
+		size_t shared; // oligos of the target sequence in clusters of se
+	};
+	vector<Candidate> candidates; // in the order of the output
+
+	unordered_map<Cluster,size_t> occurrences; // oligos of the target sequence, by cluster
+	for( const auto& e2pocl: po_cluster ) {
+		occurrences[ e2pocl.second ]++;
+	}
+
+	min_set.forEach( [&]( const Sequence se ) {
+		size_t shared = 0;
+		for( const auto& e2oc: occurrences ) {
+			if( cluster_sequences[ e2oc.first ].has( se )) shared += e2oc.second;
+		}
 
-	for( const Sequence& se: min_set ) {
 		for( auto it2fr = trie.source.instance_fragments.from.equal_range( se ) ; it2fr.first != it2fr.second ; ++it2fr.first ) {
-			const Fragment& fr = trie.source.fragments.at( it2fr.first->second );
-			const auto a2 = al.align(
-				content, amb.range().lo(), amb.range().size(),
-				trie.source.getSource(), fr.getRange().lo(), fr.getRange().size()
-			);
-
-			assert( a2.L > 0 );
-			aligned_sequences.emplace_back( se, make_pair( 100.0 * a2.M / a2.L, a2.L ));
+			candidates.push_back( Candidate{ se, it2fr.first->second, shared });
+		}
+	});
+
+	assert( candidates.size() > 0 );
+
+	vector<size_t> ranked( candidates.size());
+	for( size_t i = 0 ; i < ranked.size() ; i++ ) ranked[i] = i;
+	stable_sort( ranked.begin(), ranked.end(), [&candidates]( size_t i, size_t j ) { return candidates[i].shared > candidates[j].shared; });
+
+	vector<Alignment::Element> alignments( candidates.size()); // by candidate; L=0 if abandoned
+	unordered_map<TypeFragment,Alignment::Element> aligned;   // alignments by fragment content (\see groupFragments)
+
+	double max_score = 0; // maximum match percentage after alignment
+
+	for( const size_t i: ranked ) {
+		const Sequence se = candidates[i].se;
+		const Fragment& fr = trie.source.fragments.at( candidates[i].fra );
+		const bool long_sequences = min( target_sequence_length, LLength( fr.getRange().size())) >= Alignment::max_length_smallest_sequence;
+
+// 	the same content, aligned (or abandoned) before: the same alignment (NOTE: the band of long sequences also
+// 	depends on the Sequence; the best match percentage never decreases)
+		const TypeFragment same = same_fragment.at( candidates[i].fra );
+		const auto cached = aligned.find( same );
+
+		Alignment::Element& a2 = alignments[i];
+
+		if( !long_sequences && ( cached != aligned.end())) {
+			a2 = cached->second;
+		} else {
+			const string s = trie.source.getSource().unpack( fr.getRange().lo(), fr.getRange().size()); // NOTE: the alignment reads unpacked strings
+
+			long dlo, dhi;
+			a2 = ( long_sequences && band( po_cluster, se, q.s, s, amb.range().lo(), dlo, dhi ))
+				? al.align( // long sequences: within the band of the oligos shared by the sequences
+					q.s, amb.range().lo(), amb.range().size(),
+					s, 0, s.size(),
+					dlo, dhi, max_score
+				)
+				: al.align(
+					q.s, amb.range().lo(), amb.range().size(),
+					s, 0, s.size(),
+					max_score
+				);
+
+			if( !long_sequences ) aligned.emplace( same, a2 );
 		}
-	}
 
-	assert( aligned_sequences.size() > 0 );
+		if( a2.L > 0 ) max_score = max( max_score, 100.0 * a2.M / a2.L );
+	}
 
 // 	(4) pick source sequences with highest match percentage
-	struct { // reverse lexicographic order on match percentage
-		bool operator() ( const pair<Sequence,pair<double,LLength>> a, const pair<Sequence,pair<double,LLength>> b ) const { 
-			return ( a.second.first < b.second.first );
-		};
-	} sequenceAlignmentCompare;
-
-// 	maximum match percentage after alignment
-	const double max_score = max_element( aligned_sequences.begin(), aligned_sequences.end(), sequenceAlignmentCompare )->second.first;
-
-	for( const auto& as: aligned_sequences ) {
-		if( as.second.first != max_score ) continue;
+	for( size_t i = 0 ; i < candidates.size() ; i++ ) {
+		const Alignment::Element& a2 = alignments[i];
+		if( !a2.L || ( 100.0 * a2.M / a2.L != max_score )) continue;
 		
 		print( out,
-			na, trie.source.instances.at( as.first ),
-			as.second.first, as.second.second,
+			na, trie.source.instances.at( candidates[i].se ),
+			100.0 * a2.M / a2.L, a2.L,
 			target_sequence_length, min_set.size(), max_set.size()
 		);
 	}
 }
+/**
+ * The Sequences of each Cluster of the source, as compressed bitmaps: the minimum and maximum sets of
+ * sequences are built with word-wide operations on them (\see onSequence)
+ */
+void Match::indexClusters() {
+	vector<pair<Cluster,const set<Sequence>*>> clusters;
+	for( const auto& e2se: trie.source.clusters.to ) {
+		clusters.emplace_back( e2se.first, &e2se.second );
+		if( !e2se.second.empty()) sequences = max( sequences, *e2se.second.rbegin() + 1 );
+	}
+
+	cluster_sequences.resize( clusters.empty() ? 0 : clusters.back().first + 1 );
+	parallelFor( threads, clusters.size(), [&]( size_t i ) {
+		cluster_sequences[ clusters[i].first ] = SequenceBitmap( *clusters[i].second );
+	});
+}
+
+/**
+ * Group the fragments of the source by content: alignments of a target sequence to fragments with the same
+ * content are the same; they are calculated once (\see onSequence)
+ */
+void Match::groupFragments() {
+	vector<TypeFragment> fragments;
+	for( const auto& e2fr: trie.source.fragments.from ) {
+		fragments.push_back( e2fr.first );
+	}
+
+	auto unpack = [this]( TypeFragment f ) {
+		const Range<Position>& r = trie.source.fragments.at( f ).getRange();
+		return trie.source.getSource().unpack( r.lo(), r.size());
+	};
+
+	vector<size_t> hashes( fragments.size());
+	parallelFor( threads, fragments.size(), [&]( size_t i ) {
+		hashes[i] = hash<string>()( unpack( fragments[i] ));
+	});
+
+	unordered_map<size_t,vector<TypeFragment>> firsts; // first fragment of each content, by hash of the content
+
+	for( size_t i = 0 ; i < fragments.size() ; i++ ) {
+		vector<TypeFragment>& fi = firsts[ hashes[i] ];
+
+		TypeFragment same = fragments[i];
+		for( TypeFragment f: fi ) {
+			if( unpack( f ) == unpack( fragments[i] )) { same = f; break; }
+		}
+
+		if( same == fragments[i] ) fi.push_back( same );
+		same_fragment.emplace( fragments[i], same );
+	}
+}
+
+/**
+ * Band of diagonals [\param dlo,\param dhi] for the alignment of the target sequence (at \param lo in \param co)
+ * with fragment \param s of Sequence \param se
+ * 
+ * The oligos of the target sequence in clusters of \param se (\param po_cluster) are located in \param s: each
+ * pair of positions is a diagonal. The band covers the diagonals of most pairs (without the 5% most extreme on
+ * each side: oligos repeated in \param s), plus band_margin on each side
+ * 
+ * \returns false if none of the oligos is found in \param s
+ */
+bool Match::band( const deque<pair<Position,Cluster>>& po_cluster, const Sequence se, const string& co, const string& s, const Position lo, long& dlo, long& dhi ) const {
+	if( s.size() < le ) return false;
+
+	const uint64_t base = 31; // rolling hash of the oligos
+
+	auto hash = []( const char* o, Length l ) {
+		uint64_t h = 0;
+		for( Length k = 0 ; k < l ; k++ ) h = h * base + uint64_t( o[k] );
+		return h;
+	};
+
+	unordered_multimap<uint64_t,Position> oligos; // oligos of the target sequence in clusters of se, by hash
+	for( const auto& e2pocl: po_cluster ) {
+		if( !cluster_sequences.at( e2pocl.second ).has( se )) continue;
+
+		oligos.emplace( hash( co.data() + e2pocl.first, le ), e2pocl.first );
+	}
+	if( oligos.empty()) return false;
+
+	uint64_t top = 1; // base^(le-1)
+	for( Length k = 1 ; k < le ; k++ ) top *= base;
+
+	vector<long> diagonals;
+	uint64_t h = hash( s.data(), le );
+
+	for( size_t q = 0 ; q + le <= s.size() ; q++ ) {
+		if( q ) h = ( h - uint64_t( s[q-1] ) * top ) * base + uint64_t( s[q+le-1] );
+
+		for( auto it = oligos.equal_range( h ) ; it.first != it.second ; ++it.first ) {
+			const Position p = it.first->second;
+			if( co.compare( p, le, s, q, le )) continue; // hash collision
+
+			diagonals.push_back( long( p - lo ) - long( q ));
+		}
+	}
+	if( diagonals.empty()) return false;
+
+	sort( diagonals.begin(), diagonals.end());
+
+	const size_t x = diagonals.size() / 20;
+	dlo = diagonals.at( x ) - band_margin;
+	dhi = diagonals.at( diagonals.size()-1 - x ) + band_margin;
+
+	return true;
+}
+
 /**
  * Display the result of a match against the target sequence on one line
  */
@@ -248,9 +450,6 @@ ostream& Match::print(
 	const LLength min_set_size,
 	const LLength max_set_size
 ) {
-	static mutex lock;
-
-	lock.lock();
 	out
 		<< target_sequence_name // name of the target sequence
 		<< '\t' << ( !source_sequence_name.size() ? "-" : source_sequence_name.c_str()) // name of the best matching source sequence
@@ -262,8 +461,7 @@ ostream& Match::print(
 		<< '\t' << min_set_size
 		<< '\t' << max_set_size
 
-		<< endl;
-	lock.unlock();
+		<< '\n';
 
 	return out;
 }
@@ -0,0 +1,320 @@
+#define __ParserFasta_cpp__
+
+#include <cstring>
+#include <cerrno>
+#include <array>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ParserFasta.h"
+#include "Gunzip.h"
+
+/**
+ * Scanner for FASTA files: reads blocks of bytes and calls the event listeners of a ParserFasta
+ * with whole runs of unambiguous or ambiguous nucleotides
+ * 
+ * Same language as the former flex/bison parser:
+ *  - a name is a '>' followed by the rest of the line (at least one character)
+ *  - [ACGTacgt] are nucleotides, [RYWSMKHBVDNrywsmkhbvdn] are ambiguous nucleotides (translated with asc2nu)
+ *  - everything else (including new lines) is ignored: runs continue across lines
+ *  - a file is a non-empty sequence of fragments; each fragment is a name followed by at least one nucleotide
+ * 
+ * NOTE: with SSE2, unambiguous runs are classified and translated 16 bytes at a time
+ */
+class FastaScanner {
+private:
+	enum ByteClass : unsigned char { ignored = 0, nucleotide, ambiguous, name_start };
+	enum State { body, name_mark, in_name };
+
+	/**
+	 * Class of each byte
+	 */
+	struct ByteClasses {
+		array<ByteClass,256> c;
+
+		ByteClasses() {
+			c.fill( ignored );
+			for( const char* p = "ACGTacgt" ; *p ; p++ ) c[ Symbol( *p )] = nucleotide;
+			for( const char* p = "RYWSMKHBVDNrywsmkhbvdn" ; *p ; p++ ) c[ Symbol( *p )] = ambiguous;
+			c[ Symbol( '>' )] = name_start;
+
+// 	the vectorized translation of unambiguous nucleotides assumes these codes
+			assert(( asc2nu['A'] == 0x1 ) && ( asc2nu['C'] == 0x2 ) && ( asc2nu['G'] == 0x4 ) && ( asc2nu['T'] == 0x8 ));
+			assert(( asc2nu['a'] == 0x1 ) && ( asc2nu['c'] == 0x2 ) && ( asc2nu['g'] == 0x4 ) && ( asc2nu['t'] == 0x8 ));
+		};
+	};
+
+	static const ByteClasses classes;
+	static const size_t run_chunk = 1 << 16; // long unambiguous runs are passed in pieces: the run buffer stays small
+
+	ParserFasta& parser;
+	const string& path;
+
+	State state = body;
+
+	string name;
+	string run;                    // current run of nucleotides (translated)
+	ByteClass run_class = ignored; // class of the current run
+
+	bool b_named = false; // a name was read
+	Position bases = 0;   // number of nucleotides since the last name
+
+	/**
+	 * Pass the current run to the parser
+	 */
+	inline void flush() {
+		if( run.empty()) return;
+
+		if( !b_named ) error( "parsing error ( ", path, " ): sequence before the first fragment name" );
+
+		if( run_class == nucleotide ) {
+			parser.addNucleotides( run );
+		} else {
+			parser.addAmbig( run );
+		}
+
+		bases += run.size();
+		run.clear();
+	};
+
+	inline void onName() {
+		flush();
+		if( b_named && !bases ) error( "parsing error ( ", path, " ): empty fragment" );
+
+		parser.addFragmentName( name, path );
+
+		b_named = true;
+		bases = 0;
+		name.clear();
+		run_class = ignored;
+	};
+
+#ifdef __SSE2__
+	/**
+	 * Append to the run the leading unambiguous nucleotides of the 16 bytes at \param p
+	 * 
+	 * \returns the number of nucleotides appended
+	 */
+	inline unsigned int nucleotides16( const char* p ) {
+		const __m128i x = _mm_or_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( p )), _mm_set1_epi8( 0x20 )); // lower case
+
+		const __m128i a = _mm_cmpeq_epi8( x, _mm_set1_epi8( 'a' ));
+		const __m128i c = _mm_cmpeq_epi8( x, _mm_set1_epi8( 'c' ));
+		const __m128i g = _mm_cmpeq_epi8( x, _mm_set1_epi8( 'g' ));
+		const __m128i t = _mm_cmpeq_epi8( x, _mm_set1_epi8( 't' ));
+
+		const unsigned int mask = _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( a, c ), _mm_or_si128( g, t )));
+		const unsigned int k = ( mask == 0xFFFF ) ? 16 : __builtin_ctz( ~mask );
+		if( !k ) return 0;
+
+// 	same as asc2nu: A=1, C=2, G=4, T=8
+		const __m128i nu = _mm_or_si128(
+			_mm_or_si128( _mm_and_si128( a, _mm_set1_epi8( 0x1 )), _mm_and_si128( c, _mm_set1_epi8( 0x2 ))),
+			_mm_or_si128( _mm_and_si128( g, _mm_set1_epi8( 0x4 )), _mm_and_si128( t, _mm_set1_epi8( 0x8 ))));
+
+		const size_t s = run.size();
+		run.resize( s+16 );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( &run[s] ), nu );
+		run.resize( s+k );
+
+		return k;
+	};
+#endif
+
+	/**
+	 * Scan nucleotides from \param p up to \param e, or up to the start of a name
+	 * 
+	 * \returns position after the last byte scanned
+	 */
+	inline const char* scanBody( const char* p, const char* e ) {
+		while( p < e ) {
+			if(( run_class == nucleotide ) && ( run.size() >= run_chunk )) flush(); // NOTE: consecutive unambiguous sections are contiguous in the content
+
+#ifdef __SSE2__
+			if( run_class == nucleotide ) { // fast path: in an unambiguous run
+				while(( e-p >= 16 ) && ( run.size() < run_chunk )) {
+					const unsigned int k = nucleotides16( p );
+					p += k;
+					if( k < 16 ) break;
+				}
+				if( p == e ) break;
+			}
+#endif
+			const Symbol c = *p++;
+
+			switch( classes.c[c] ) {
+			case nucleotide:
+			case ambiguous:
+				if( classes.c[c] != run_class ) {
+					flush();
+					run_class = classes.c[c];
+				}
+				run += asc2nu[c];
+				break;
+			case name_start:
+				flush();
+				state = name_mark;
+				return p;
+			default:
+				break;
+			}
+		}
+
+		return p;
+	};
+
+public:
+	FastaScanner( ParserFasta& pa, const string& pt ): parser( pa ), path( pt ) {};
+
+	/**
+	 * Scan the block of bytes from \param p up to \param e (continues the previous block)
+	 */
+	void scan( const char* p, const char* e ) {
+		while( p < e ) {
+			switch( state ) {
+			case body:
+				p = scanBody( p, e );
+				break;
+			case name_mark: // '>' must be followed by at least one character on the same line
+				if( *p == '\n' ) {
+					p++;
+					state = body;
+				} else {
+					state = in_name;
+				}
+				break;
+			case in_name: {
+				const char* q = static_cast<const char*>( memchr( p, '\n', e-p ));
+				if( !q ) {
+					name.append( p, e );
+					return;
+				}
+
+				name.append( p, q );
+				p = q+1;
+				onName();
+				state = body;
+				break;
+			}
+			}
+		}
+	};
+
+	/**
+	 * End of the file
+	 */
+	void finish() {
+		if( state == in_name ) onName();
+		flush();
+
+		if( !b_named ) error( "parsing error ( ", path, " ): no fragments" );
+		if( !bases ) error( "parsing error ( ", path, " ): empty fragment" );
+
+		parser.onFinish();
+	};
+};
+
+const FastaScanner::ByteClasses FastaScanner::classes;
+
+/**
+ * Open file descriptor, closed on destruction
+ */
+struct InputFile {
+	const int fd;
+
+	InputFile( const string& path ): fd( open( path.c_str(), O_RDONLY )) {};
+	~InputFile() { if( fd >= 0 ) close( fd ); };
+};
+
+/**
+ * Read-only mapping of a whole file, unmapped on destruction
+ */
+struct InputMapping {
+	void* data;
+	const size_t size;
+
+	InputMapping( int fd, size_t n ): data( mmap( nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0 )), size( n ) {
+		if( data != MAP_FAILED ) madvise( data, size, MADV_SEQUENTIAL ); // NOTE: a hint; more read-ahead, pages dropped behind
+	};
+	~InputMapping() { if( data != MAP_FAILED ) munmap( data, size ); };
+};
+
+void ParserFasta::parse( const string& path, unsigned int threads ) {
+	static const size_t block_size = 1 << 20;
+
+	const InputFile in( path );
+	struct stat st;
+	if(( in.fd < 0 ) || ( fstat( in.fd, &st ) < 0 )) {
+		error( "cannot open sequence file ( ", path, " )" );
+	}
+
+	FastaScanner scanner( *this, path );
+	const Gunzip::Sink sink = [&scanner]( const char* p, size_t n ) { scanner.scan( p, p+n ); };
+
+	if( S_ISREG( st.st_mode ) && ( st.st_size > 0 )) { // regular file: scan the mapping directly
+		const InputMapping m( in.fd, st.st_size );
+
+		if( m.data != MAP_FAILED ) {
+			const char* p = static_cast<const char*>( m.data );
+
+			if( Gunzip::isGzip( p, m.size )) {
+				Gunzip::memory( path, p, m.size, threads, sink );
+			} else {
+				onReserve( b_reverse_complement ? 2*m.size : m.size ); // the content is at most the size of the file (x2 for reverse complements)
+				scanner.scan( p, p+m.size );
+			}
+
+			scanner.finish();
+			return;
+		}
+	}
+
+// 	not a regular file (e.g. a pipe) or cannot be mapped: read in blocks
+	vector<char> block( block_size );
+	bool head = true; // the first block tells whether the input is compressed
+
+	while( true ) {
+		const ssize_t n = read( in.fd, block.data(), block.size());
+		if( n < 0 ) {
+			if( errno == EINTR ) continue;
+			error( "cannot read sequence file ( ", path, " )" );
+		}
+		if( !n ) break;
+
+		if( head && Gunzip::isGzip( block.data(), n )) {
+			Gunzip::stream( path, block.data(), n, in.fd, sink );
+			break;
+		}
+		head = false;
+
+		sink( block.data(), n );
+	}
+
+	scanner.finish();
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
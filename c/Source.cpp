@@ -109,49 +109,59 @@ void Source::readIsolationList( const string& isolation_file_name )
 
 void Source::filterMelting( const unsigned int threads, const double max_melting, const double strand_concentration, const double salt_concentration ) {
 	if( &fold_output != &onull ) fold_output << fixed;
-	spin( threads, *this, &Source::_filterMelting, max_melting, strand_concentration, salt_concentration );
+
+	const double t0 = max_melting + Thermo::K; // convert from Celsius to Kelvin
+	const Thermo th( t0, strand_concentration, salt_concentration );
+
+	vector<const Fragment*> frs;
+	for( const auto& e2fr: fragments.from ) {
+		frs.push_back( &e2fr.second );
+	}
+
+	const string head = content.unpack( 0, maxim ); // \see Source::_filterMelting
+
+	parallelFor( threads, frs.size(), [&]( size_t i ){
+		_filterMelting( *frs.at( i ), th, head );
+	});
+
+	b_melted = true;
+	melting = Melting{ max_melting, strand_concentration, salt_concentration };
 }
 
 /**
- * Remove occurrences of subsequences that have melting temperatures higher than \param max_melting
+ * Remove occurrences of subsequences of fragment \param fr that have melting temperatures higher than
+ * the temperature of \param th
+ * 
+ * Each range is unpacked on its own, with one byte of context on each side (hairpins look up terminal
+ * mismatches and A/T penalties at ( i-1, j+1 )), after \param head, the first maxim nucleotides of the
+ * content
+ * 
+ * NOTE: Fold::match looks up the terminal A/T penalty at ( i, j ), j being a length, i.e. in the first
+ *       maxim nucleotides of its string: starting each string with \param head keeps the results of a
+ *       Fold over the whole content
  */
-void Source::_filterMelting( bool& first, const double& max_melting, const double& strand_concentration, const double& salt_concentration ) {
-	const auto e = fragments.from.end();
-	static One2One<TypeFragment,Fragment>::type_from::iterator i;
-	static mutex lock;
-	static double t0 = max_melting + Thermo::K; // convert from Celsius to Kelvin
-
-	static Thermo th( t0, strand_concentration, salt_concentration );
+void Source::_filterMelting( const Fragment& fr, const Thermo& th, const string& head ) {
+	for( const Range<Position>& r: fr.getAmbigCompl()) {
+		if( r.size() < minim ) continue; // skip ranges that are too small
 
-	lock.lock();
-
-	while( true ) {
-		if( first ) {
-			i = fragments.from.begin();
-			first = false;
-		}
+		const Position b = r.lo() ? r.lo()-1 : 0; // context
+		const Position e = min( r.hi()+1, content.size());
 
-		if( i == e ) break;
-		auto ii = i;
+		const string s = head + content.unpack( b, e-b );
+		const Position lo = head.size() + r.lo() - b; // start of the range in s
 
-		lock.unlock();
-		for( const Range<Position>& r: ii->second.getAmbigCompl()) {
-			if( r.size() < minim ) continue; // skip ranges that are too small
+		deque<Length> o( s.size(), 0 ); // lengths of the range, at the positions of s
+		copy( max_length_at.begin() + r.lo(), max_length_at.begin() + r.hi(), o.begin() + lo );
 
 // 	WARNING: allocating stack storage for the Fold (like so: "Fold h") fails on some systems (clusters)
 // 	Possible explanation: stack overflow for on stack storage
 // 	Solution: Allocate the Fold on heap storage (new Fold)
-			Fold* h = new Fold( content, r.lo(), r.size(), max_length_at, minim, min( r.size(), Position( maxim )), th, fold_output );
-			h->fold();
-			delete h; // make sure to delete the Fold !
-		}
-		lock.lock();
+		Fold* h = new Fold( s, lo, r.size(), o, minim, min( r.size(), Position( maxim )), th, fold_output );
+		h->fold();
+		delete h; // make sure to delete the Fold !
 
-		i++;
+		copy( o.begin() + lo, o.begin() + lo + r.size(), max_length_at.begin() + r.lo());
 	}
-	lock.unlock();
-
-	return;
 }
 
 /**
@@ -191,6 +201,48 @@ void Source::showSequence( ostream& out, Sequence s ) const {
 	}
 }
 
+void Source::parseFiles( const vector<string>& files, unsigned int threads ) {
+	if(( files.size() < 2 ) || ( threads < 2 )) {
+		for( const string& fn: files ) {
+			FileStage st( minim, maxim, b_reverse_complement );
+			st.parse( fn, threads );
+			merge( st );
+		}
+		return;
+	}
+
+	vector<unique_ptr<FileStage>> stages( files.size());
+	size_t merged = 0; // number of files merged so far, in order
+	mutex merging;
+
+	parallelFor( threads, files.size(), [&]( size_t i ) {
+		unique_ptr<FileStage> st( new FileStage( minim, maxim, b_reverse_complement ));
+		st->parse( files.at( i ), threads ); // NOTE: BGZF blocks are decompressed by the threads of the pool left free
+
+// 	merge all the files that are ready, in order; the others wait in their stage
+		lock_guard<mutex> g( merging );
+		stages.at( i ) = move( st );
+
+		while(( merged < stages.size()) && stages.at( merged )) {
+			merge( *stages.at( merged ));
+			stages.at( merged ).reset();
+			merged++;
+		}
+	});
+}
+
+void Source::merge( FileStage& st ) {
+	const Position offset = content.size();
+
+	content.append( st.getContent());
+	max_length_at.insert( max_length_at.end(), st.max_length_at.begin(), st.max_length_at.end());
+
+	for( FileStage::StagedFragment& f: st.staged ) {
+		f.amb >> offset; // NOTE: positions of the stage start at 0
+		addFragment( f.name, f.file_name, f.amb, f.rc );
+	}
+}
+
 // This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
 // 
 // (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
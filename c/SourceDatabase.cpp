@@ -0,0 +1,210 @@
+#define __SourceDatabase_cpp__
+
+#include <cstring>
+
+#include "SourceDatabase.h"
+#include "IndexFile.h"
+
+#include "Source.h"
+
+static const char magic[8] = { 'a', 'o', 'd', 'p', 's', 'd', 'b', '\0' };
+static const uint64_t byte_order = 0x0102030405060708ULL;
+
+static const string what = "sequence database file";
+
+/**
+ * Bits of a double, as a 64-bit value of the file
+ */
+static inline uint64_t double2value( double d ) {
+	uint64_t v;
+	memcpy( &v, &d, sizeof( v ));
+	return v;
+}
+static inline double value2double( uint64_t v ) {
+	double d;
+	memcpy( &d, &v, sizeof( d ));
+	return d;
+}
+
+void SourceDatabase::write( ostream& out, const Source& src ) {
+	IndexWriter w( out );
+
+// 	header
+	w.block( magic, sizeof( magic ));
+	w.value( version );
+	w.value( byte_order );
+	w.value( src.minim );
+	w.value( src.maxim );
+	w.value( src.max_ambiguities );
+	w.value( src.max_crowded_ambiguities );
+	w.value( src.b_reverse_complement );
+
+	w.value( src.b_melted );
+	w.value( double2value( src.melting.max_melting ));
+	w.value( double2value( src.melting.strand_concentration ));
+	w.value( double2value( src.melting.salt_concentration ));
+
+// 	content
+	const PackedSequence& c = src.content;
+	w.value( c.n );
+	w.block( c.words.data(), c.words.size());
+	w.block( c.flags.data(), c.flags.size());
+	w.block( c.runs.data(), c.runs.size());
+	w.text( c.ambiguous );
+
+	const vector<Length> mla( src.max_length_at.begin(), src.max_length_at.end());
+	w.block( mla.data(), mla.size());
+
+// 	sequences
+	w.value( src.instances.to.size());
+	for( const auto& e2na: src.instances.to ) {
+		w.value( e2na.first );
+		w.text( e2na.second );
+	}
+
+// 	fragments (same as in TrieIndex)
+	w.value( src.fragments.from.size());
+	for( const auto& e2fr: src.fragments.from ) {
+		const Fragment& fr = e2fr.second;
+
+		w.value( e2fr.first );
+		w.value( src.instance_fragments.to.at( e2fr.first ));
+		w.value( fr.b_reverse_complement );
+		w.text( fr.file_name );
+
+		vector<Position> ambig{ fr.getRange().lo(), fr.getRange().size() };
+		for( const Range<Position>& r: fr.getAmbig()) {
+			ambig.push_back( r.lo());
+			ambig.push_back( r.size());
+		}
+		w.block( ambig.data(), ambig.size());
+	}
+
+// 	excluded fragments
+	w.value( src.excluded.size());
+	for( const string& e: src.excluded ) {
+		w.text( e );
+	}
+
+	out.flush();
+	if( !w.good()) error( "cannot write sequence database" );
+}
+
+/**
+ * Check that parameter \param name of the Source (\param expected) is the one the database was written with (\param v)
+ */
+static void parameter( const string& path, const string& name, uint64_t v, uint64_t expected ) {
+	if( v == expected ) return;
+
+	error( "the sequence database (", path, ") was written with a different value of --"+name );
+}
+
+void SourceDatabase::read( const string& path, Source& src ) {
+	assert( src.content.empty() && src.fragments.from.empty());
+
+	const IndexMapping m( what, path );
+
+// 	header
+	if(( m.size < 2*sizeof( magic )) || memcmp( m.data + sizeof( magic ), magic, sizeof( magic ))) error( "not an aodp sequence database file (", path, ")" );
+
+	IndexReader r( what, path, m.data, 2*sizeof( magic ), m.data+m.size ); // after the magic (and its size)
+
+	const uint64_t ve = r.value();
+	if( ve != version ) error( "unsupported sequence database file version (", path, "): ", ve, "\n ** expecting version ", version );
+
+	if( r.value() != byte_order ) error( "sequence database file written on an architecture with a different byte order (", path, ")" );
+
+	const uint64_t minim = r.value();
+	const uint64_t maxim = r.value();
+	parameter( path, "oligo-size", minim, src.minim );
+	parameter( path, "oligo-size", maxim, src.maxim );
+	parameter( path, "max-ambiguities", r.value(), src.max_ambiguities );
+	parameter( path, "max-crowded-ambiguities", r.value(), src.max_crowded_ambiguities );
+	parameter( path, "reverse-complement", r.value(), src.b_reverse_complement );
+
+	src.b_melted = r.value();
+	src.melting.max_melting = value2double( r.value());
+	src.melting.strand_concentration = value2double( r.value());
+	src.melting.salt_concentration = value2double( r.value());
+
+// 	content: the packed arrays are copied as they are
+	PackedSequence& c = src.content;
+	c.n = r.value();
+
+	uint64_t nw, nf, nr;
+	const uint64_t* words = r.block<uint64_t>( nw );
+	const uint64_t* flags = r.block<uint64_t>( nf );
+	const PackedSequence::AmbiguousRun* runs = r.block<PackedSequence::AmbiguousRun>( nr );
+
+	c.words.assign( words, words+nw );
+	c.flags.assign( flags, flags+nf );
+	c.runs.assign( runs, runs+nr );
+	c.ambiguous = r.text();
+
+	if(( nw != ( uint64_t( c.n ) + 31 ) / 32 + 1 ) || ( nf != ( nw + 63 ) / 64 )) error( "corrupt "+what+" (", path, ")" );
+	for( const PackedSequence::AmbiguousRun& a: c.runs ) {
+		if(( a.lo > a.hi ) || ( a.hi > c.n ) || ( a.offset + ( a.hi-a.lo ) > c.ambiguous.size())) error( "corrupt "+what+" (", path, ")" );
+	}
+
+	uint64_t nm;
+	const Length* mla = r.block<Length>( nm );
+	if( nm != c.n ) error( "corrupt "+what+" (", path, ")" );
+	src.max_length_at.assign( mla, mla+nm );
+
+// 	sequences: each sequence is a target by itself (\see Source::addFragment)
+	for( uint64_t i = 0, n = r.value() ; i < n ; i++ ) {
+		const Sequence se = r.value();
+		const string na = r.text();
+
+		if( src.instances.emplace( na, se )) error( "corrupt "+what+" (", path, ")" );
+		src.targets.emplace( { se }, na );
+		src.next_sequence = max( src.next_sequence, se+1 );
+	}
+
+// 	fragments
+	for( uint64_t i = 0, n = r.value() ; i < n ; i++ ) {
+		const TypeFragment fra = r.value();
+		const Sequence se = r.value();
+		const bool rc = r.value();
+		const string fn = r.text();
+
+		uint64_t k;
+		const Position* a = r.block<Position>( k );
+		if(( k < 2 ) || ( k % 2 ) || ( uint64_t( a[0] ) + a[1] > c.n )) error( "corrupt "+what+" (", path, ")" );
+
+		set<Range<Position>> ambig;
+		for( uint64_t j = 2 ; j < k ; j += 2 ) {
+			ambig.emplace( a[j], a[j+1] );
+		}
+
+		const Cover<Position> amb( Range<Position>( a[0], a[1] ), ambig );
+
+		src.instance_fragments.emplace( se, fra );
+		src.fragment_position.emplace( fra, amb.range().hi());
+		src.fragments.emplace( fra, Fragment{ fn, amb, src.maxim, rc });
+		src.next_fragment = max( src.next_fragment, fra+1 );
+	}
+
+// 	excluded fragments
+	for( uint64_t i = 0, n = r.value() ; i < n ; i++ ) {
+		src.excluded.push_back( r.text());
+	}
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -0,0 +1,129 @@
+#define __ThreadPool_cpp__
+
+#include "ThreadPool.h"
+
+thread_local bool ThreadPool::inside = false;
+
+ThreadPool& ThreadPool::instance() {
+	static ThreadPool pool;
+	return pool;
+}
+
+ThreadPool::~ThreadPool() {
+	lock.lock();
+	stopping = true;
+	lock.unlock();
+
+	wake.notify_all();
+
+	for( thread& th: workers ) { // wait for all (idle) threads to finish
+		th.join();
+	}
+}
+
+void ThreadPool::run( unsigned int t, const function<void( unsigned int )>& task ) {
+	if(( t <= 1 ) || inside ) { // no need for other threads; also avoids waiting on our own pool
+		for( unsigned int w = 0 ; w < t ; w++ ) {
+			task( w );
+		}
+		return;
+	}
+
+// 	state of this invocation; lives on the stack of the calling thread until all workers are done
+	mutex done_lock;
+	condition_variable done;
+	unsigned int pending = t-1;
+	exception_ptr failure;
+
+	auto call = [&]( unsigned int w ) {
+		try {
+			task( w );
+		} catch( ... ) {
+			lock_guard<mutex> g( done_lock );
+			if( !failure ) failure = current_exception(); // keep the first one
+		}
+	};
+
+	lock.lock();
+
+	while( workers.size() < t-1 ) { // the calling thread is also a worker
+		workers.emplace_back( &ThreadPool::work, this );
+	}
+
+	for( unsigned int w = 1 ; w < t ; w++ ) {
+		tasks.push_back({ &done, [&, w]() {
+			call( w );
+
+			lock_guard<mutex> g( done_lock );
+// 	NOTE: notify under lock, so that the state of the invocation outlives the notification
+			if( !--pending ) done.notify_all();
+		}});
+	}
+
+	lock.unlock();
+	wake.notify_all();
+
+	inside = true;
+	call( 0 );
+
+// 	take back the workers not started yet: no thread of the pool may be free to start them
+	deque<function<void()>> own;
+
+	lock.lock();
+	for( auto it = tasks.begin() ; it != tasks.end() ; ) {
+		if( it->invocation == &done ) {
+			own.push_back( move( it->f ));
+			it = tasks.erase( it );
+		} else {
+			++it;
+		}
+	}
+	lock.unlock();
+
+	for( function<void()>& f: own ) f();
+	inside = false;
+
+	unique_lock<mutex> g( done_lock );
+	done.wait( g, [&]{ return !pending; });
+
+	if( failure ) rethrow_exception( failure );
+}
+
+/**
+ * Worker thread: execute tasks until the pool is destroyed
+ */
+void ThreadPool::work() {
+	inside = true;
+
+	unique_lock<mutex> g( lock );
+
+	while( true ) {
+		wake.wait( g, [this]{ return stopping || !tasks.empty(); });
+		if( tasks.empty()) return; // stopping
+
+		function<void()> f = move( tasks.front().f );
+		tasks.pop_front();
+
+		g.unlock();
+		f();
+		g.lock();
+	}
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -3,20 +3,33 @@
 #include "Trie.h"
 #include "TrieSlice.h"
 
-Trie::Trie( Source& so, Length m, Length M ) : source( so ), minim( m ), maxim( M ), cake() {
+/**
+ * Maximum number of consecutive positions handed out at once to a thread (\see Trie::loop, Trie::confirm)
+ */
+static const size_t grain_size = 4096;
+
+/**
+ * Number of chunks of fragments bucketed independently, for each thread (\see Trie::cover)
+ * 
+ * NOTE: more chunks balance the threads better, but use more memory for the offsets (chunks x slices)
+ */
+static const size_t chunks_per_thread = 4;
+
+Trie::Trie( Source& so, Length m, Length M, Depth depth ) : source( so ), minim( m ), maxim( M ), fixed_depth( depth ), cake() {
+	assert(( fixed_depth >= min_depth ) && ( fixed_depth <= max_depth ));
 };
 
 void Trie::buildSlices() {
-	Slice cake_index( 0 );
+	const Slice count = Slice( 1 ) << ( 2*fixed_depth ); // number of unambiguous prefixes
 
-	for( Symbol n1: { 1, 2, 4, 8 }) {
-		for( Symbol n2: { 1, 2, 4, 8 }) {
-			for( Symbol n3: { 1, 2, 4, 8 }) {
-				for( Symbol n4: { 1, 2, 4, 8 }) {
-					prefixes.emplace( nu2p4( n1, n2, n3, n4 ), cake_index++ );
-				}
-			}
+	for( Slice cake_index = 0 ; cake_index < count ; cake_index++ ) {
+		Prefix pr = 0;
+		for( Depth d = 0 ; d < fixed_depth ; d++ ) { // two bits of the index for each base of the prefix
+			pr <<= 4;
+			pr |= pre2nu.at(( cake_index >> ( 2*( fixed_depth-1-d ))) & 0x3 );
 		}
+
+		prefixes.emplace( pr, cake_index );
 	}
 
 	for( const auto& e2fr: source.fragments.to ) {
@@ -32,9 +45,9 @@ void Trie::buildSlices() {
 		}
 	}
 
-	cake.resize( prefixes.size());
+	newSlices();
 
-	set<Prefix4> ap4; // temporary storage for ambiguous prefixes
+	set<Prefix> ap; // temporary storage for ambiguous prefixes
 
 	for( const auto& e2fr: source.fragments.to ) {
 		Cover<Position> c = e2fr.first.getAmbig();
@@ -48,7 +61,7 @@ void Trie::buildSlices() {
 					break;
 				}
 
-				ap4.emplace( nu2p4( source.getSource(), p++ ));
+				ap.emplace( nu2pr( source.getSource(), p++, fixed_depth ));
 			}
 		}
 	}
@@ -58,39 +71,65 @@ void Trie::buildSlices() {
 		prefix_match.emplace( e2pr.first, e2pr.second );
 	}
 
-	for( const Prefix4& pr1: ap4 ) {  // ambiguous prefixes match any unambiguous prefixes
-		for( const auto& e2pr2: prefixes ) {
-			if( p4ma( pr1, e2pr2.first ) == 4 ) {
-				prefix_match.emplace( pr1, e2pr2.second );
-			}
+	for( const Prefix& pr1: ap ) {  // ambiguous prefixes match any unambiguous prefixes
+		for( const Prefix& pr2: matchingPrefixes( pr1, 0 )) {
+			prefix_match.emplace( pr1, prefixes.at( pr2 ));
 		}
 	}
 
 // 	populate the diff1 prefix match
 	for( const auto& e2pr1: prefixes ) {
-		for( const auto& e2pr2: prefixes ) { // add all diff1 unambiguous prefixes
-			if( p4ma( e2pr1.first, e2pr2.first ) == 3 ) {
-				prefix_diff1.emplace( e2pr1.first, e2pr2.second );
-			}
+		for( const Prefix& pr2: matchingPrefixes( e2pr1.first, 1 )) { // add all diff1 unambiguous prefixes
+			prefix_diff1.emplace( e2pr1.first, prefixes.at( pr2 ));
 		}
-		for( const Prefix4& pr3: ap4 ) { // add all matching diff1 unambiguous prefixes
-			if( p4ma( e2pr1.first, pr3 ) == 3 ) {
-				prefix_diff1.emplace( pr3, e2pr1.second );
-			}
+	}
+
+	for( const Prefix& pr1: ap ) { // add all matching diff1 unambiguous prefixes
+		for( const Prefix& pr2: matchingPrefixes( pr1, 1 )) {
+			prefix_diff1.emplace( pr1, prefixes.at( pr2 ));
 		}
 	}
 };
 
 void Trie::newSlice( Position p ) {
-	static Slice cake_index = 0; // incremental index
+	prefixes.emplace( nu2pr( source.getSource(), p, fixed_depth ), prefixes.size());
+};
 
-	Prefix4 pr = nu2p4( source.getSource(), p );
-	if( prefixes.emplace( pr, cake_index ).second ) {
-// 	here, the insertion has actually taken place
-		++cake_index;
+void Trie::newSlices() {
+	while( cake.size() < prefixes.size()) {
+		cake.emplace_back( fixed_depth );
 	}
 };
 
+vector<Prefix> Trie::matchingPrefixes( Prefix pr, Length diff ) const {
+	vector<pair<Prefix,Length>> r{{ 0, 0 }}; // partial prefixes; number of differences
+
+	for( Depth d = 0 ; d < fixed_depth ; d++ ) { // extend partial prefixes with one base at a time
+		const Symbol sy = ( pr >> ( 4*( fixed_depth-1-d ))) & 0xF;
+
+		vector<pair<Prefix,Length>> e;
+		for( const auto& e2di: r ) {
+			for( Symbol nu: pre2nu ) {
+				const Length di = e2di.second + !( nu & sy );
+				if( di > diff ) continue;
+
+				e.emplace_back(( e2di.first << 4 ) | nu, di );
+			}
+		}
+
+		r.swap( e );
+	}
+
+	vector<Prefix> m;
+	for( const auto& e2di: r ) {
+		if( e2di.second == diff ) {
+			m.push_back( e2di.first );
+		}
+	}
+
+	return m;
+};
+
 const set<string> Trie::getNodesWithMatches() const {
 	set<string> result;
 
@@ -103,34 +142,112 @@ const set<string> Trie::getNodesWithMatches() const {
 
 /**
  * Load all subsequences from the associated "source" database into the Trie; multi-threaded
+ * 
+ * All subsequences are first bucketed by slice (parallel counting sort over chunks of fragments,
+ * \see parallelRanges); each thread then owns whole slices and adds their subsequences without locking
  */
 void Trie::cover( unsigned int threads ){
-	spin( threads, *this, &Trie::_cover );
+	const Slice slices = prefixes.size();
+
+// 	split the fragments in chunks of roughly equal lengths
+	LLength total = 0;
+	for( const auto& e2fr: source.instance_fragments.from ) {
+		total += source.fragments.at( e2fr.second ).getRange().size();
+	}
+
+	bucket_chunks.clear();
+
+	LLength chunk = 0, length = 0;
+	for( auto fr = source.instance_fragments.from.cbegin() ; fr != source.instance_fragments.from.cend() ; ++fr ) {
+		if( length >= chunk * ( total / ( threads * chunks_per_thread ))) {
+			bucket_chunks.push_back( fr );
+			chunk++;
+		}
+
+		length += source.fragments.at( fr->second ).getRange().size();
+	}
+
+	bucket_chunks.push_back( source.instance_fragments.from.cend());
+
+	const size_t chunks = bucket_chunks.size() - 1;
+
+// 	count subsequences for each chunk and slice
+	bucket_offsets.assign( chunks * slices, 0 );
+	bucket_counting = true;
+
+	parallelRanges( threads, chunks, 1, [this]( size_t lo, size_t hi ){
+		for( size_t ch = lo ; ch < hi ; ch++ ) _bucket( ch );
+	});
+
+// 	calculate write offsets: for each slice, chunks are written in order
+	bucket_slices.assign( slices+1, 0 );
+
+	size_t offset = 0;
+	for( Slice sl = 0 ; sl < slices ; sl++ ) {
+		bucket_slices.at( sl ) = offset;
+
+		for( size_t ch = 0 ; ch < chunks ; ch++ ) {
+			size_t count = bucket_offsets.at( ch * slices + sl );
+			bucket_offsets.at( ch * slices + sl ) = offset;
+			offset += count;
+		}
+	}
+
+	bucket_slices.at( slices ) = offset;
+
+// 	write all subsequences in their buckets
+	bucket_elements.resize( offset );
+	bucket_counting = false;
+
+	parallelRanges( threads, chunks, 1, [this]( size_t lo, size_t hi ){
+		for( size_t ch = lo ; ch < hi ; ch++ ) _bucket( ch );
+	});
+
+// 	add the subsequences of each bucket to its slice; the largest buckets first
+	vector<Slice> order( slices );
+	for( Slice sl = 0 ; sl < slices ; sl++ ) {
+		order.at( sl ) = sl;
+	}
+
+	stable_sort( order.begin(), order.end(), [this]( Slice a, Slice b ){
+		return ( bucket_slices.at( a+1 ) - bucket_slices.at( a )) > ( bucket_slices.at( b+1 ) - bucket_slices.at( b ));
+	});
+
+	parallelFor( threads, slices, [this, &order]( size_t i ){ _cover( order.at( i )); });
+
+// 	cleanup
+	vector<BucketElement>().swap( bucket_elements );
+	vector<size_t>().swap( bucket_offsets );
+	vector<size_t>().swap( bucket_slices );
+	bucket_chunks.clear();
 }
 
-void Trie::_cover( bool& first ){
-	loop( first, ambigCoverComplement, lengthMax, elementAdd );
-	return;
+void Trie::_bucket( size_t ch ){
+	bucket( ch, ambigCoverComplement, lengthMax );
 }
 
 /**
- * Add a subsequence starting at to the corresponding TrieSlice
+ * Worker: add the subsequences of a whole bucket to its slice
  * 
- * \param p is the position in the single string source
+ * NOTE: each slice is owned by exactly one thread; no locking is necessary
  */
-void Trie::add( Position p, Length l, Sequence s ) {
-	getSlice( p ).add( source, s, p, l, minim );
-};
+void Trie::_cover( Slice sl ){
+	TrieSlice& slice = cake.at( sl );
+	for( size_t i = bucket_slices.at( sl ) ; i < bucket_slices.at( sl+1 ) ; i++ ) {
+		const BucketElement& e = bucket_elements[i];
+		slice.insert( source, e.s, e.p, e.l, minim );
+	}
+}
 
 /**
  * Mark all ambiguous subsequences from the associated "source" database into the Trie
  */
 void Trie::touch( unsigned int threads ){
-	spin( threads, *this, &Trie::_touch );
+	_touch( threads );
 }
 
-void Trie::_touch( bool& first ){
-	loop( first, ambigCover, lengthCover, elementMark );
+void Trie::_touch( unsigned int threads ){
+	loop( threads, ambigCover, lengthCover, elementMark );
 }
 
 /**
@@ -145,12 +262,7 @@ void Trie::mark( Position p, Length l, Sequence s ) {
 
 void Trie::smallDiff( unsigned int threads )
 {
-	spin( threads, *this, &Trie::_smallDiff );
-}
-
-void Trie::_smallDiff( bool& first )
-{
-	loop( first, range, lengthRange, elementDiff );
+	loop( threads, range, lengthRange, elementDiff );
 }
 
 /**
@@ -158,12 +270,12 @@ void Trie::_smallDiff( bool& first )
  */
 void Trie::diff( Position p, Length l, Sequence s )
 {
-	for( auto i2pr = prefix_match.equal_range( nu2p4( source.getSource(), p ))
+	for( auto i2pr = prefix_match.equal_range( nu2pr( source.getSource(), p, fixed_depth ))
 			; i2pr.first != i2pr.second ; ++i2pr.first ) { // look at matching prefixes
 		cake.at( i2pr.first->second ).smallDiff( source, p, l, s, minim, 0 );
 	}
 
-	for( auto i2pr = prefix_diff1.equal_range( nu2p4( source.getSource(), p ))
+	for( auto i2pr = prefix_diff1.equal_range( nu2pr( source.getSource(), p, fixed_depth ))
 			; i2pr.first != i2pr.second ; ++i2pr.first ) { // look at prefixes with small difference
 		cake.at( i2pr.first->second ).smallDiff( source, p, l, s, minim, 1 );
 	}
@@ -178,66 +290,49 @@ void Trie::diff( Position p, Length l, Sequence s )
 void Trie::confirm( unsigned int threads, const string& s, const vector<pair<string,Range<Position>>>& a ) {
 	if( !s.size() || !a.size()) return; // if there is no content
 
-	spin( threads, *this, &Trie::_confirm, s, a );  // simply spins the _confirm worker function
-}
-/**
- * Iterate through all subsequences of a vector of reference strings \param a
- */
-void Trie::_confirm( bool& first, const string& s, const vector<pair<string,Range<Position>>>& a ) {
-	static vector<pair<string,Range<Position>>>::const_iterator i, e;
-
-	static Position p;
-	static mutex lock;
-
-	lock.lock();
-
-	if( first ) { // initialization
-		first = false;
-
-		i = a.cbegin(); // iterator for all reference sequences
-		e = a.cend(); // end of the vector of range sequences
+	struct Segment { // all positions of a reference sequence
+		size_t i;      // index of the reference sequence
+		size_t offset; // index of the first position in the sequence of all positions
+	};
 
-		if( i == e ) goto last_element; // the vector of references may have been empty (defence)
-		p = i->second.lo(); // position at the start of the sequence
-	} else {
-		if( i == e ) goto last_element; // some other thread may have finished processing
+	vector<Segment> segments;
+	size_t n = 0; // number of positions
+	for( size_t i = 0 ; i < a.size() ; i++ ) {
+		segments.push_back( Segment{ i, n });
+		n += a.at( i ).second.size();
 	}
 
-	while( true ) { // sequence loop
-		while( true ) { // position loop
-			Length le = i->second.cover( p, minim, maxim ); // length '0' means the 
+	parallelRanges( threads, n, grain_size, [&]( size_t lo, size_t hi ){
+		auto sg = upper_bound( segments.cbegin(), segments.cend(), lo, []( size_t i, const Segment& sg ){ return i < sg.offset; }) - 1;
 
-			if( !le ) break; // to sequence loop
+		for( size_t i = lo ; i < hi ; ++sg ) { // segment loop
+			const auto& e2ra = a.at( sg->i );
+			const size_t last = min( hi, sg->offset + e2ra.second.size());
+			if( i >= last ) continue; // empty segment
 
-			Position po = p;
-			Sequence re = source.reference.at( i->first );
+			const Sequence re = source.reference.at( e2ra.first );
 
-			lock.unlock();
+			for( ; i < last ; i++ ) { // position loop
+				const Position p = e2ra.second.lo() + ( i - sg->offset );
+				const Length le = e2ra.second.cover( p, minim, maxim );
 
-			__confirm( s, re, po, le ); // call the worker for each subsequence
+// 	NOTE: the length is 0 for all positions past the first one that does not fit
+				if( !le ) {
+					i = last;
+					break;
+				}
 
-			lock.lock();
-			if( i == e ) goto last_element; // the sequence counter may have been changed by other threads outside the lock
-			++p;
+				__confirm( s, re, p, le ); // call the worker for each subsequence
+			}
 		}
-
-		assert( i != e );
-
-		if( ++i == e ) goto last_element;
-
-		p = i->second.lo();
-	}
-
-
-last_element:
-	lock.unlock();
+	});
 }
 
 /**
  * Confirm all matching slices of the trie against a subsequence of a reference sequence
  */
 void Trie::__confirm( const string& s, Sequence re, Position p, Length l ) {
-	for( auto i2pr = prefixes.equal_range( nu2p4( s, p )) ; i2pr.first != i2pr.second ; ++i2pr.first ) { // for each prefix matching the subsequence
+	for( auto i2pr = prefixes.equal_range( nu2pr( s, p, fixed_depth )) ; i2pr.first != i2pr.second ; ++i2pr.first ) { // for each prefix matching the subsequence
 		cake.at( i2pr.first->second ).confirm( *this, source, s, re, p, l, minim ); // call the worker of that trie slice
 	}
 }
@@ -247,111 +342,116 @@ void Trie::__confirm( const string& s, Sequence re, Position p, Length l ) {
  */
 void Trie::collectMatches( unsigned int threads )
 {
-	spin( threads, *this, &Trie::_collectMatches );
+	parallelFor( threads, prefixes.size(), [this]( size_t sl ){ _collectMatches( sl ); });
 }
 
 /**
- * Worker function: collect all clusters from each TrieSlice into the map of matches
+ * Collect all occurrences of all clusters in one pass, grouped by cluster id: the occurrences of
+ * cluster c are at [\param offsets[c],\param offsets[c+1]) in \param ma, in no particular order
  * 
- * WARNING: filling Trie::matches (shared resource) must be done under lock
+ * \param counts number of occurrences of each cluster (\see countMatches)
  */
-void Trie::_collectMatches( bool& first ) {
-	static decltype( cake )::iterator cr( cake.begin()), en( cake.end());
-	static mutex lock;
-
-	lock.lock();
+void Trie::collectMatches( unsigned int threads, const vector<size_t>& counts, vector<PositionDepthLength>& ma, vector<size_t>& offsets )
+{
+	offsets.assign( 1, 0 );
+	for( const size_t n: counts ) {
+		offsets.push_back( offsets.back() + n );
+	}
 
-	while( cr != en ) {
-		TrieSlice& sl = *cr++;
+	ma.resize( offsets.back());
 
-		lock.unlock();
-		sl.collectMatches( *this, sl.getDepth());
-		lock.lock();
+	for( size_t c = 0 ; c < counts.size() ; c++ ) {
+		match_next.push_back( ma.data() + offsets.at( c ));
 	}
 
-	lock.unlock();
+	collectMatches( threads );
+
+	for( size_t c = 0 ; c < counts.size() ; c++ ) {
+		assert( match_next.at( c ) == ma.data() + offsets.at( c+1 )); // WARNING: counts must be those of countMatches
+	}
+	vector<PositionDepthLength*>().swap( match_next );
 }
 
 /**
- * Generates a unique, persistent identifier for each unique cluster (set of Sequences) contained
- * in Trie nodes
- * 
- * Since the unique identifier is the order in the [sorted] set of Sequence sets,
- * the cluster identifier is persistent
+ * Worker: collect all clusters from a TrieSlice into the map of matches
  * 
- * WARNING: single threaded
+ * WARNING: filling Trie::matches (shared resource) must be done under lock
  */
-void Trie::encodeClusters() {
-	set<set<Sequence>> cluster_set;
-	for( const TrieSlice& slice: cake ) { // collect all 
-		slice.encodeClusters( cluster_set, slice.getDepth(), 0 );
-	}
+void Trie::_collectMatches( Slice sl ) {
+	TrieSlice& slice = cake.at( sl );
+	slice.collectMatches( *this, slice.getDepth());
+}
 
-	assert( source.clusters.from.size() == 0 );
+/**
+ * Number of occurrences of each cluster in the Trie (indexed by cluster id), without collecting them
+ */
+vector<size_t> Trie::countMatches( unsigned int threads )
+{
+	vector<size_t> counts( source.clusters.to.size(), 0 );
 
-	int cluster_id = 0; // cluster counter
-	for( const auto& cluster: cluster_set ) {
-		source.clusters.emplace( cluster, cluster_id++ );
-	}
+	parallelFor( threads, prefixes.size(), [this, &counts]( size_t sl ){ _countMatches( sl, counts ); });
+
+	return counts;
 }
 
 /**
- * Collects and writes a unique cluster identifier in each node associated with it
+ * Worker: count the occurrences of each cluster in a TrieSlice
+ * 
+ * WARNING: \param counts (shared resource) must be updated under lock
  */
-void Trie::collectClusters( unsigned int threads )
-{
-	spin( threads, *this, &Trie::_collectClusters );
+void Trie::_countMatches( Slice sl, vector<size_t>& counts ) {
+	cake.at( sl ).countMatches( *this, counts );
 }
 
 /**
- * Worker function: collects and writes a unique cluster identifier in each node associated with it
- * by calling each slice's collectClusters method
+ * Generates a unique, persistent identifier for each unique cluster (set of Sequences) contained
+ * in Trie nodes and writes it in each node associated with it
  * 
- * NOTE: operations on each slice will be in isolated threads or sequentially
- * WARNING: incrementing the cluster id needs to be done under lock in TrieSlice::collectClusters
+ * Since the unique identifier is the order in the [sorted] set of Sequence sets,
+ * the cluster identifier is persistent
+ * 
+ * Slices intern their clusters in parallel (\see ClusterTable), nodes hold provisional
+ * identifiers until all clusters are known and ranked
  */
-void Trie::_collectClusters( bool& first ) {
-	static mutex lock;
+void Trie::encodeClusters( unsigned int threads ) {
+	assert( source.clusters.from.size() == 0 );
 
-	static decltype( cake )::iterator cr( cake.begin()), en( cake.end());
+	parallelFor( threads, prefixes.size(), [this]( size_t sl ){ _encodeClusters( sl ); });
 
-	lock.lock();
+	cluster_table.rank( threads, source.clusters );
 
-	while( cr != en ) {
-		TrieSlice& slice = *cr++;
+	parallelFor( threads, prefixes.size(), [this]( size_t sl ){ _collectClusters( sl ); });
 
-		lock.unlock();
-		slice.collectClusters( *this, slice.getDepth());
-		lock.lock();
-	}
-	lock.unlock();
+	cluster_table.clear();
 }
 
 /**
- * Sort all matches by the sequence and the position where they occur
+ * Worker: interns the clusters of all the nodes of a TrieSlice
  */
-void Trie::sortMatches( unsigned int threads )
-{
-	spin( threads, *this, &Trie::_sortMatches );
+void Trie::_encodeClusters( Slice sl ) {
+	cake.at( sl ).encodeClusters( cluster_table );
 }
 
 /**
- * Worker function: sort all matches by the sequence and the position where they occur
+ * Worker: replaces the provisional cluster identifiers of a TrieSlice with the final ones
  */
-void Trie::_sortMatches( bool& first ) {
-	static decltype( matches )::iterator cr( matches.begin()), en( matches.end());
-	static mutex lock;
-
-	lock.lock();
-	while( cr !=en ) {
-		decltype( cr->second )& li = cr->second;
-		cr++;
+void Trie::_collectClusters( Slice sl ) {
+	cake.at( sl ).collectClusters( cluster_table );
+}
 
-		lock.unlock();
-		::sort( li.begin(), li.end(), pdlCompare );
-		lock.lock();
+/**
+ * Sort all matches by the sequence and the position where they occur
+ */
+void Trie::sortMatches( unsigned int threads )
+{
+	vector<vector<PositionDepthLength>*> lists;
+	for( auto& e2li: matches ) {
+		lists.push_back( &e2li.second );
 	}
-	lock.unlock();
+
+	parallelFor( threads, lists.size(), [&lists]( size_t i ){
+		::sort( lists.at( i )->begin(), lists.at( i )->end(), pdlCompare );
+	});
 }
 
 /**
@@ -360,45 +460,26 @@ void Trie::_sortMatches( bool& first ) {
  */
 void Trie::filterHomolo( unsigned int threads, const Length max_homolo )
 {
-	spin( threads, *this, &Trie::_filterHomolo, max_homolo );
+	const vector<pair<Prefix,Slice>> slices( prefixes.cbegin(), prefixes.cend());
+
+	parallelFor( threads, slices.size(), [&]( size_t i ){
+		_filterHomolo( slices.at( i ).first, slices.at( i ).second, max_homolo );
+	});
 }
 
 /**
- * Worker thread: remove occurrences of subsequences that have self-homologous sections
- * longer than \param max_homolo
+ * Worker: remove occurrences of subsequences that have self-homologous sections
+ * longer than \param max_homolo from the slice \param sl associated with the prefix \param pr
  */
-void Trie::_filterHomolo( bool& first, const Length& max_homolo ) {
-	static mutex lock;
-	static decltype( prefixes )::iterator cr, en;
-
-	lock.lock();
+void Trie::_filterHomolo( Prefix pr, Slice sl, Length max_homolo ) {
+	const auto e2ho = prho( pr, fixed_depth ); // the homologous section at the end of the prefix
+	const Length ho = maxHomolo( pr2nu( pr, fixed_depth )); // the longest homologous section anywhere in the prefix
 
-	if( first ) { // initialization
-		cr = prefixes.begin();
-		en = prefixes.end();
-
-		first = false;
+	if(( e2ho.first > max_homolo ) || ( ho > max_homolo )) { // the whole slice is busted
+		cake.at( sl ).filterHomolo( source, max_homolo, 0, max_homolo+1, minim );
+	} else { // call recursive filterHomolo for the slice
+		cake.at( sl ).filterHomolo( source, max_homolo, e2ho.second, e2ho.first, minim );
 	}
-
-	while( cr != en ) { // for each prefix/slice
-// 	Local variables; use outside lock
-		const auto e2ho = p4ho( cr->first ); // the homologous section of the prefix
-		const Slice sl  = cr->second; // the slice associated with the prefix
-
-		++cr;
-
-		lock.unlock();
-
-		if( e2ho.first > max_homolo ) { // the whole slice is busted
-			cake.at( sl ).filterHomolo( source, max_homolo, 0, max_homolo+1, minim );
-		} else { // call recursive filterHomolo for the slice
-			cake.at( sl ).filterHomolo( source, max_homolo, e2ho.second, e2ho.first, minim );
-		}
-
-		lock.lock();
-	}
-
-	lock.unlock();
 }
 
 const Cluster Trie::getClusterId( Position p, Length l ) {
@@ -409,119 +490,79 @@ const bool Trie::getCluster( const string& s, Position p, Length l, Cluster& clu
 	return getSlice( s, p ).getCluster( *this, s, p, l, clu );
 }
 
-void Trie::loop( bool& first, const CoverFunction& cov, const LengthFunction& len, const ElementFunction& ele ) {
-// // 	Thread-shared counters
-// // 	WARNING: any changes must be done under lock
-	static decltype( source.instance_fragments.from )::const_iterator fr, en;
-	static Cover<Position> c;
-	static Cover<Position>::iterator r;
-	static Position p ;
-
-	static mutex lock;
-
-	lock.lock();
-// 	initialization
-	if( first ) {
-// 	Only the first thread will execute the initialization
-		fr = source.instance_fragments.from.begin();
-		en = source.instance_fragments.from.end();
-
-		while( true ) {
-			if( fr == en ) {
-// 	exit condition
-				goto last_sequence;
-			}
-
-			c = cov( *this, source.fragments.at( fr->second ));
-			if( !!c ) {
-				break;
-			}
-
-			++fr;
-			continue;
+void Trie::loop( unsigned int threads, const CoverFunction& cov, const LengthFunction& len, const ElementFunction& ele ) {
+	struct Segment { // all positions of a Range of a fragment
+		decltype( source.instance_fragments.from )::const_iterator fr;
+		Cover<Position>::iterator r;
+		size_t offset; // index of the first position in the sequence of all positions
+	};
+
+	vector<Segment> segments;
+	size_t n = 0; // number of positions
+	for( auto fr = source.instance_fragments.from.cbegin() ; fr != source.instance_fragments.from.cend() ; ++fr ) { // fragment loop
+		const Cover<Position>& c = cov( *this, source.fragments.at( fr->second ));
+
+		for( Cover<Position>::iterator r = c.begin() ; r != c.end() ; ++r ) { // range loop
+			segments.push_back( Segment{ fr, r, n });
+			n += r->size();
 		}
+	}
 
-		r = c.begin();
-// 	HERE: c is non-empty
-		assert( !!c );
-
-		p = r->lo();
-		first = false;
-	} else {
-// 	For subsequent threads, make sure that there still is processing to do
+	parallelRanges( threads, n, grain_size, [&]( size_t lo, size_t hi ){
+		auto sg = upper_bound( segments.cbegin(), segments.cend(), lo, []( size_t i, const Segment& sg ){ return i < sg.offset; }) - 1;
 
-// 	NOTE: the first threads may have finished processing the whole input before
-// 	      the last threads get to initialization
-		if( fr == en ) {
-// 	repeat exit condition
-			goto last_sequence; // to last_sequence
-		}
-	}
+		for( size_t i = lo ; i < hi ; ++sg ) { // segment loop
+			Cover<Position>::iterator r = sg->r;
+			const size_t last = min( hi, sg->offset + r->size());
+			if( i >= last ) continue; // empty segment
 
-	assert( !!c );
+			const Cover<Position>& c = cov( *this, source.fragments.at( sg->fr->second ));
+			const Sequence se = sg->fr->first;
 
-// 	Loop
-	while( true ) { // fragment loop
-		while( true ) { // range loop
-			while( true ) { // position loop
-				Length le = len( source, c, r, p, minim, maxim );
+			for( ; i < last ; i++ ) { // position loop
+				const Position p = r->lo() + ( i - sg->offset );
+				const Length le = len( source, c, r, p, minim, maxim );
 
+// 	NOTE: the length is 0 for all positions past the first one that does not fit
 				if( !le ) {
+					i = last;
 					break;
 				}
 
-				Position po = p++; // increment the position iterator
-				Sequence se = fr->first;
+				ele( *this, p, le, se );
+			}
+		}
+	});
+};
 
-				lock.unlock();
+void Trie::bucket( size_t ch, const CoverFunction& cov, const LengthFunction& len ) {
+	const Slice slices = prefixes.size();
 
-// 	Communicate with the cover function using local, thread-specific variables po le se
-				ele( *this, po, le, se );
+	size_t* offsets = &bucket_offsets.at( ch * slices );
 
-// 	NOTE: position(p), range (r) and sequence (s) may have been changed magically by other threads outside the lock
-				lock.lock();
+	for( auto fr = bucket_chunks.at( ch ) ; fr != bucket_chunks.at( ch+1 ) ; ++fr ) { // fragment loop
+		const Cover<Position>& c = cov( *this, source.fragments.at( fr->second ));
+		const Sequence se = fr->first;
 
-				if( fr == en ) {
-// 	repeat exit condition
-					goto last_sequence; // to last_sequence
-				}
+		for( Cover<Position>::iterator r = c.begin() ; r != c.end() ; ++r ) { // range loop
+			for( Position p = r->lo() ; ; p++ ) { // position loop
+				Length le = len( source, c, r, p, minim, maxim );
 
-				if( r == c.end()) {
+				if( !le ) {
 					break;
 				}
-			} // position loop
-
-
-			if(( r == c.end()) || ( ++r == c.end())) {
-				break; // to fragment loop
-			}
-
-			p = r->lo();
-		} // range loop
 
-		while( true ) { // increment sequence
-			if( ++fr == en ) {
-// 	exit condition
-				goto last_sequence; // to last_sequence
-			}
+				const Slice sl = prefixes.at( nu2pr( source.getSource(), p, fixed_depth ));
 
-			c = cov( *this, source.fragments.at( fr->second ));
-			if( !c ) {
-				continue;
+				if( bucket_counting ) {
+					offsets[sl]++;
+				} else {
+					bucket_elements[ offsets[sl]++ ] = BucketElement{ p, se, le };
+				}
 			}
-
-			r = c.begin();
-			assert( r != c.end());
-			p = r->lo();
-
-			assert( *r & p );
-			break;
 		}
-	}  // fragment loop
-
-last_sequence:
-	lock.unlock();
-};
+	}
+}
 
 // TEST
 
@@ -558,6 +599,16 @@ void Trie::measure(
 	}
 }
 
+void Trie::memory( MemoryBreakdown& m ) const {
+	source.memory( m );
+
+	for( const TrieSlice& slice: cake ) {
+		slice.memory( m );
+	}
+
+	m["trie matches"] += footprint( matches );
+}
+
 void Trie::print() const {
 	for( const auto& sl: cake ) {
 		sl.print( source, 0, Depth( fixed_depth ));
@@ -584,7 +635,7 @@ void Trie::_find( const string& s ) const {
 	cout << s << endl;
 	assert( nu.size() >= fixed_depth );
 
-	Prefix4 pr = nu2p4( nu, 0 );
+	Prefix pr = nu2pr( nu, 0, fixed_depth );
 
 	cake.at( prefixes.at( pr )).find( source, nu, r );
 
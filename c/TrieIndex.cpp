@@ -0,0 +1,287 @@
+#define __TrieIndex_cpp__
+
+#include <cstring>
+
+#include "TrieIndex.h"
+
+#include "Source.h"
+#include "Trie.h"
+#include "TrieSlice.h"
+
+static const char magic[8] = { 'a', 'o', 'd', 'p', 'i', 'd', 'x', '\0' };
+static const uint64_t byte_order = 0x0102030405060708ULL;
+static const unsigned short unambiguous_mask = ( 1 << 1 ) | ( 1 << 2 ) | ( 1 << 4 ) | ( 1 << 8 ); // children masks of unambiguous symbols (A, C, G, T)
+
+void TrieIndex::write( ostream& out, const Trie& trie ) {
+	const Slice count = Slice( 1 ) << ( 2*trie.fixed_depth ); // number of unambiguous prefixes
+
+	if( trie.cake.size() != count ) error( "cannot write index: only unambiguous tries are supported" );
+
+	for( const auto& e2sl: trie.prefixes ) { // slices must be in the order of their prefix (\see TrieIndex::getCluster)
+		Slice sl = 0;
+		for( Depth d = 0 ; d < trie.fixed_depth ; d++ ) {
+			sl = ( sl << 2 ) | nu2pre[( e2sl.first >> ( 4*( trie.fixed_depth-1-d ))) & 0xF ];
+		}
+
+		if( sl != e2sl.second ) error( "cannot write index: only unambiguous tries are supported" );
+	}
+
+	IndexWriter w( out );
+
+// 	header
+	w.block( magic, sizeof( magic ));
+	w.value( version );
+	w.value( byte_order );
+	w.value( trie.fixed_depth );
+	w.value( trie.minim );
+	w.value( trie.maxim );
+	w.value( count );
+
+	const Source& src = trie.source;
+
+// 	content: the packed arrays, as they are (\see SourceDatabase::write)
+	const PackedSequence& c = src.content;
+	w.value( c.n );
+	w.block( c.words.data(), c.words.size());
+	w.block( c.flags.data(), c.flags.size());
+	w.block( c.runs.data(), c.runs.size());
+	w.text( c.ambiguous );
+
+// 	slices, in the order of their unambiguous prefix
+	for( const TrieSlice& slice: trie.cake ) {
+		const TrieNodes& st = slice.store;
+		if( !st.children_ambig.empty()) error( "cannot write index: only unambiguous tries are supported" );
+
+		w.value( st.nodes());
+		w.block( st.source.data(), st.source.size());
+		w.block( st.children_table.data(), st.children_table.size());
+		w.block( st.children_mask.data(), st.children_mask.size());
+		w.block( st.cluster.data(), st.cluster.size());
+	}
+
+// 	sequences
+	w.value( src.instances.to.size());
+	for( const auto& e2na: src.instances.to ) {
+		w.value( e2na.first );
+		w.text( e2na.second );
+	}
+
+// 	fragments
+	w.value( src.fragments.from.size());
+	for( const auto& e2fr: src.fragments.from ) {
+		const Fragment& fr = e2fr.second;
+
+		w.value( e2fr.first );
+		w.value( src.instance_fragments.to.at( e2fr.first ));
+		w.value( fr.b_reverse_complement );
+		w.text( fr.file_name );
+
+		vector<Position> ambig{ fr.getRange().lo(), fr.getRange().size() };
+		for( const Range<Position>& r: fr.getAmbig()) {
+			ambig.push_back( r.lo());
+			ambig.push_back( r.size());
+		}
+		w.block( ambig.data(), ambig.size());
+	}
+
+// 	clusters, in cluster id order
+	vector<uint64_t> offsets{ 0 };
+	vector<Sequence> sequences;
+	for( const auto& e2se: src.clusters.to ) {
+		if( e2se.first != offsets.size()-1 ) error( "cannot write index: cluster ids are not contiguous" );
+
+		sequences.insert( sequences.end(), e2se.second.begin(), e2se.second.end());
+		offsets.push_back( sequences.size());
+	}
+	w.block( offsets.data(), offsets.size());
+	w.block( sequences.data(), sequences.size());
+
+	out.flush();
+	if( !w.good()) error( "cannot write index" );
+}
+
+TrieIndex::TrieIndex( const string& pa ): path( pa ), mapping( "index file", pa ), data( mapping.data ), size( mapping.size ) {
+// 	header
+	if(( size < 2*sizeof( magic )) || memcmp( data + sizeof( magic ), magic, sizeof( magic ))) error( "not an aodp index file (", path, ")" );
+
+	IndexReader r( "index file", path, data, 2*sizeof( magic ), data+size ); // after the magic (and its size)
+
+	const uint64_t ve = r.value();
+	if( ve != version ) error( "unsupported index file version (", path, "): ", ve, "\n ** expecting version ", version );
+
+	if( r.value() != byte_order ) error( "index file written on an architecture with a different byte order (", path, ")" );
+
+	fixed_depth = r.value();
+	minim = r.value();
+	maxim = r.value();
+
+	const uint64_t count = r.value();
+	if(( fixed_depth < Trie::min_depth ) || ( fixed_depth > Trie::max_depth ) || ( count != ( uint64_t( 1 ) << ( 2*fixed_depth )))) {
+		error( "corrupt index file (", path, ")" );
+	}
+
+// 	content: the packed arrays are copied (\see SourceDatabase::read)
+	content.n = r.value();
+
+	uint64_t nw, nf, nr;
+	const uint64_t* words = r.block<uint64_t>( nw );
+	const uint64_t* flags = r.block<uint64_t>( nf );
+	const PackedSequence::AmbiguousRun* runs = r.block<PackedSequence::AmbiguousRun>( nr );
+
+	content.words.assign( words, words+nw );
+	content.flags.assign( flags, flags+nf );
+	content.runs.assign( runs, runs+nr );
+	content.ambiguous = r.text();
+
+	if(( nw != ( uint64_t( content.n ) + 31 ) / 32 + 1 ) || ( nf != ( nw + 63 ) / 64 )) error( "corrupt index file (", path, ")" );
+	for( const PackedSequence::AmbiguousRun& a: content.runs ) {
+		if(( a.lo > a.hi ) || ( a.hi > content.n ) || ( a.offset + ( a.hi-a.lo ) > content.ambiguous.size())) error( "corrupt index file (", path, ")" );
+	}
+
+// 	slices: pointers to the arrays in the mapping
+	slices.resize( count );
+	for( SliceNodes& sn: slices ) {
+		sn.nodes = r.value();
+
+		uint64_t s, c, m, u;
+		sn.source = r.block<PositionLength>( s );
+		sn.children_table = r.block<array<Node,4>>( c );
+		sn.children_mask = r.block<unsigned short>( m );
+		sn.cluster = r.block<Cluster>( u );
+
+		if(( s != sn.nodes ) || ( c != sn.nodes ) || ( m != sn.nodes ) || ( u != sn.nodes ) || !sn.nodes ) error( "corrupt index file (", path, ")" );
+
+// 	NOTE: getCluster follows the nodes without any checks: the node sources must be in the content, the
+// 	      children in the slice, with unambiguous symbols only, and not empty (each step of the lookup
+// 	      consumes at least one nucleotide)
+		for( Node n = 0 ; n < sn.nodes ; n++ ) {
+			if( uint64_t( position( sn.source[n] )) + length( sn.source[n] ) > content.n ) error( "corrupt index file (", path, ")" );
+			if( sn.children_mask[n] & ~unambiguous_mask ) error( "corrupt index file (", path, ")" );
+
+			for( Symbol pre = 0 ; pre < 4 ; pre++ ) {
+				if(!( sn.children_mask[n] & ( 1 << pre2nu[pre] ))) continue;
+
+				const Node ch = sn.children_table[n][pre];
+				if(( ch >= sn.nodes ) || !length( sn.source[ch] )) error( "corrupt index file (", path, ")" );
+			}
+		}
+	}
+
+	source_offset = r.offset();
+}
+
+void TrieIndex::restore( Source& src ) const {
+	IndexReader r( "index file", path, data, source_offset, data+size );
+
+	src.content = content;
+
+// 	sequences
+	for( uint64_t i = 0, n = r.value() ; i < n ; i++ ) {
+		const Sequence se = r.value();
+		src.instances.emplace( r.text(), se );
+	}
+
+// 	fragments
+	for( uint64_t i = 0, n = r.value() ; i < n ; i++ ) {
+		const TypeFragment fra = r.value();
+		const Sequence se = r.value();
+		const bool rc = r.value();
+		const string fn = r.text();
+
+		uint64_t m;
+		const Position* a = r.block<Position>( m );
+		if(( m < 2 ) || ( m % 2 )) error( "corrupt index file (", path, ")" );
+
+		set<Range<Position>> ambig;
+		for( uint64_t j = 0 ; j < m ; j += 2 ) {
+			if( uint64_t( a[j] ) + a[j+1] > content.n ) error( "corrupt index file (", path, ")" );
+			if( j ) ambig.emplace( a[j], a[j+1] );
+		}
+
+		const Cover<Position> amb( Range<Position>( a[0], a[1] ), ambig );
+
+		src.instance_fragments.emplace( se, fra );
+		src.fragment_position.emplace( fra, amb.range().hi());
+		src.fragments.emplace( fra, Fragment{ fn, amb, maxim, rc });
+	}
+
+// 	clusters: ids are increasing, sets are in increasing order
+	uint64_t no, ns;
+	const uint64_t* offsets = r.block<uint64_t>( no );
+	const Sequence* sequences = r.block<Sequence>( ns );
+
+	for( uint64_t c = 0 ; c+1 < no ; c++ ) {
+		if(( offsets[c] > offsets[c+1] ) || ( offsets[c+1] > ns )) error( "corrupt index file (", path, ")" );
+
+		const set<Sequence> s( sequences + offsets[c], sequences + offsets[c+1] );
+		src.clusters.from.emplace_hint( src.clusters.from.end(), s, c );
+		src.clusters.to.emplace_hint( src.clusters.to.end(), c, s );
+	}
+
+	for( const SliceNodes& sn: slices ) { // cluster ids of the nodes
+		for( Node n = 0 ; n < sn.nodes ; n++ ) {
+			if(( sn.cluster[n] != Cluster_invalid ) && ( uint64_t( sn.cluster[n] ) + 1 >= no )) error( "corrupt index file (", path, ")" );
+		}
+	}
+}
+
+bool TrieIndex::getCluster( const string& s, Position p, Length l, Cluster& clu ) const {
+	assert( l > fixed_depth );
+
+	Slice sl = 0; // index of the slice: the unambiguous prefix, 2 bits per base
+	for( Depth d = 0 ; d < fixed_depth ; d++ ) {
+		const Symbol pre = nu2pre[ Symbol( s.at( p+d ))];
+		if( pre > 3 ) return false; // no slice for ambiguous prefixes
+
+		sl = ( sl << 2 ) | pre;
+	}
+
+	const SliceNodes& sn = slices[sl];
+
+	Node n0 = 0;
+	p += fixed_depth;
+	l -= fixed_depth;
+
+	while( true ) { // same as TrieSlice::_getCluster, on the mapped nodes
+		const PositionLength pl0 = sn.source[n0];
+		const Position p0 = position( pl0 );
+		const Length l0 = length( pl0 );
+
+		for( Depth dd = 0 ; dd < min( l0, l ) ; dd++ ){
+			if( content[p0+dd] != Symbol( s.at( p+dd ))) return false;
+		}
+
+		if( l <= l0 ) { // the target sequence ends before the current node
+			assert( sn.cluster[n0] != Cluster_invalid ); // WARNING: make sure that the length matches --oligo-size
+
+			clu = sn.cluster[n0];
+			return true;
+		}
+
+// 	here, the target sequence continues beyond the current node
+		const Symbol sy = s.at( p+l0 );
+		if(!( sn.children_mask[n0] & ( 1 << sy ))) return false; // cannot continue in any of the children of the current node
+
+		n0 = sn.children_table[n0][ nu2pre[sy] ];
+		p += l0;
+		l -= l0;
+	}
+}
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
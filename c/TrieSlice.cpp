@@ -2,8 +2,7 @@
 
 #include "TrieSlice.h"
 
-TrieSlice::TrieSlice( Depth d ) : fixed_depth( d ), next_node( 1 ) {
-	source.emplace( 0, positionLength( 0, 0 ));
+TrieSlice::TrieSlice( Depth d ) : fixed_depth( d ) {
 }
 
 void TrieSlice::filterHomolo( Source& src, Depth max_homolo, Symbol sy0, Length h0, Length minim ) {
@@ -23,7 +22,7 @@ void TrieSlice::_filterHomolo( Source& src, Depth max_homolo, Node n0, Depth d0,
 		Symbol sy = sy0;
 		Node   n  = node( sn );
 
-		PositionLength pl = source.at( n );
+		PositionLength pl = store.getSource( n );
 		Position       p  = position( pl );
 		Length         l  = length( pl );
 
@@ -36,7 +35,7 @@ void TrieSlice::_filterHomolo( Source& src, Depth max_homolo, Node n0, Depth d0,
 						eraseChild( n0, symbol( sn ));
 					} else {
 // 	shrink
-						source.at( n ) = positionLength( p, d );
+						store.setSource( n, positionLength( p, d ));
 						eraseChildren( n );
 					}
 
@@ -57,37 +56,30 @@ next_child:
 	}
 }
 
-void TrieSlice::collectClusters( Trie& trie, Depth d ) {
-	_collectClusters( trie, d, 0 ); // call recursive worker function
+void TrieSlice::encodeClusters( ClusterTable& table ) {
+	vector<Sequence> l; // reused for all nodes
+	_encodeClusters( table, 0, l ); // call recursive worker function
 
 // 	Cleanup list of occurrences
 	occurrences.clear();
-	occurrences.rehash( occurrences.size());
 }
 
-void TrieSlice::_collectClusters( Trie& trie, Depth d, Node n ) {
+void TrieSlice::_encodeClusters( ClusterTable& table, Node n, vector<Sequence>& l ) {
 	for( auto& c: children( n )) {
-		_collectClusters( trie, d+length( source.at( n )), node( c ));
+		_encodeClusters( table, node( c ), l );
 	}
 
-	const auto o = occ( n );
+	const auto& o = occ( n );
 	if( o.empty()) return; // no occurrences
 
-	const set<Sequence> s{ o.begin(), o.end() };
-	cluster.emplace( n, trie.source.clusters.at( s )); // add cluster id to this node
+	l.assign( o.begin(), o.end());
+	store.setCluster( n, table.intern( l )); // provisional cluster id
 }
 
-void TrieSlice::encodeClusters( set<set<Sequence>>& cluster_set, Depth d, Node n ) const {
-	for( auto& c: children( n )) {
-		encodeClusters( cluster_set, d+length( source.at( n )), node( c ));
+void TrieSlice::collectClusters( const ClusterTable& table ) {
+	for( Node n = 0 ; n < store.nodes() ; n++ ) {
+		if( store.hasCluster( n )) store.setCluster( n, table.at( store.getCluster( n )));
 	}
-
-	const auto o = occ( n );
-	if( o.empty()) return; // no occurrences
-
-	const set<Sequence> s{ o.begin(), o.end() };
-
-	cluster_set.emplace( s );
 }
 
 void TrieSlice::collectMatches( Trie& trie, Depth d ) {
@@ -95,28 +87,47 @@ void TrieSlice::collectMatches( Trie& trie, Depth d ) {
 
 	_collectMatches( trie, m, d, 0 );
 
-	static mutex lock;
-	lock.lock(); // protect unique Trie::matches from multithreaded access
+	trie.matches_lock.lock(); // protect unique Trie::matches from multithreaded access
 	for( const auto& e2ma : m ) {
-		trie.matches[ e2ma.first ].push_back( e2ma.second );
+		trie.addMatch( e2ma.first, e2ma.second );
 	}
-	lock.unlock();
+	trie.matches_lock.unlock();
 }
 
 void TrieSlice::_collectMatches( Trie& trie, deque<pair<Cluster,PositionDepthLength>>& m, Depth d, Node n ) {
-	Position p = position( source.at( n ));
-	Length l   = length( source.at( n ));
+	Position p = position( store.getSource( n ));
+	Length l   = length( store.getSource( n ));
 
 	for( auto& c: children( n )) {
 		_collectMatches( trie, m, d+l, node( c ));
 	}
 
-	if( !cluster.count( n )) return; // no occurrences
+	if( !store.hasCluster( n )) return; // no occurrences
 
-	m.emplace_back( cluster.at( n ), positionDepthLength( p, d, l ));
+	m.emplace_back( store.getCluster( n ), positionDepthLength( p, d, l ));
 // 		trie.matches[ trie.source.slice_cluster.at( cluster.at( n ))].push_back( positionDepthLength( p, d, l )); // add this node's cluster id to the list of matches
 }
 
+void TrieSlice::countMatches( Trie& trie, vector<size_t>& counts ) {
+	vector<Cluster> m;
+
+	_countMatches( m, 0 );
+
+	trie.matches_lock.lock(); // protect the shared counts from multithreaded access
+	for( const Cluster c: m ) {
+		counts.at( c )++;
+	}
+	trie.matches_lock.unlock();
+}
+
+void TrieSlice::_countMatches( vector<Cluster>& m, Node n ) {
+	for( auto& c: children( n )) {
+		_countMatches( m, node( c ));
+	}
+
+	if( store.hasCluster( n )) m.push_back( store.getCluster( n )); // same nodes as _collectMatches
+}
+
 // |ACGTA|                 (p   ;l=5) <-- array<TrieSlice,fixed_depth> from Trie
 //        +|AG|            (p+5 ;l=2) <-- TrieSlice::add starts here; calls _add recursively
 //             +|CGA|      (p+7 ;l=3) 
@@ -129,20 +140,11 @@ void TrieSlice::_collectMatches( Trie& trie, deque<pair<Cluster,PositionDepthLen
  */
 // TODO: TrieSlice::_add remove debug (LOW)
 void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Length l, Length minim ) {
-	Position p0 = position( source.at( n0 ));
-	Length l0   = length( source.at( n0 ));
+	Position p0 = position( store.getSource( n0 ));
+	Length l0   = length( store.getSource( n0 ));
 
-	Depth dd;
-	bool mismatch = false;
-
-	for( dd = 0 ; dd < min( l0, l ) ; dd++ ){
-		if( src.symbol( p0+dd ) == src.symbol( p+dd )){
-			continue;
-		}
-
-		mismatch = true;
-		break;
-	}
+	Depth dd = src.common( p0, p, min( l0, l ));
+	bool mismatch = ( dd < min( l0, l ));
 
 	if( !mismatch && ( l0 == l )) {
 // (1)  n0 |-----------|E [s0,...]     =>   n0 |-----------|E [s0,...,s]
@@ -154,7 +156,7 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 
 		if( p<p0 ) {
 // 	point the source to the earlied occurrence in the database
-			source.at( n0 ) = positionLength( p, l0 );
+			store.setSource( n0, positionLength( p, l0 ));
 		}
 
 		return;
@@ -175,7 +177,7 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 
 		if( p<p0 ) {
 // 	point the source to the earlied occurrence in the database
-			source.at( n0 ) = positionLength( p, l0 );
+			store.setSource( n0, positionLength( p, l0 ));
 		}
 
 		if( childAt( n0, sy, n )){
@@ -196,32 +198,18 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 //      s  |-------|                                    +|====|E [s0,...]
 
 		Symbol sy = src.symbol( p0+dd );
-		vector<SymbolNode> ch = children( n0 );
-
-		for( auto& c: ch ) {
-			children_hash.erase( symbolNode( symbol( c ), n0 ));
-		}
-		children_list.erase( n0 );
-
-// 	insert n1
-		Node n = newChild( n0, sy, p0+dd, l0-dd );
-		for( auto& c: ch ) {
-			children_hash.emplace( symbolNode( symbol( c ), n ), node( c ));
-			children_list.emplace( n, c );
-		}
+		Node n = insertChild( n0, sy, p0+dd, l0-dd );
 
 // 	shrink n0
 		if( p<p0 ) {
 // 	point the source to the earlied occurrence in the database
-			source.at( n0 ) = positionLength( p, dd );
+			store.setSource( n0, positionLength( p, dd ));
 		} else {
-			source.at( n0 ) = positionLength( p0, dd );
+			store.setSource( n0, positionLength( p0, dd ));
 		}
 
 // 		occurrences of n
-		for( Sequence& ss: occ( n0 )) {
-			occurrences.emplace( n, ss );
-		}
+		occurrences.copy( n0, n );
 
 		occurrences.emplace( n0, s );
 
@@ -236,19 +224,7 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 	Symbol sy1 = src.symbol( p0+dd );
 	Symbol sy2 = src.symbol( p +dd );
 
-// 	capture and erase children of node n0
-	vector<SymbolNode> ch = children( n0 );
-	for( auto& c: ch ) {
-		children_hash.erase( symbolNode( symbol( c ), n0 ));
-	}
-	children_list.erase( n0 );
-
-// 	insert n1
-	Node n1 = newChild( n0, sy1, p0+dd, l0-dd );
-	for( auto& c: ch ) {
-		children_hash.emplace( symbolNode( symbol( c ), n1 ), node( c ));
-		children_list.emplace( n1, c );
-	}
+	Node n1 = insertChild( n0, sy1, p0+dd, l0-dd );
 
 // 	insert n2
 	Node n2 = newChild( n0, sy2, p+dd, l-dd );
@@ -256,9 +232,9 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 // 	shrink n0
 	if( p<p0 ) {
 // 	point the source to the earlied occurrence in the database
-		source.at( n0 ) = positionLength( p, dd );
+		store.setSource( n0, positionLength( p, dd ));
 	} else {
-		source.at( n0 ) = positionLength( p0, dd );
+		store.setSource( n0, positionLength( p0, dd ));
 	}
 
 // 	occurrences
@@ -266,9 +242,7 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 	occurrences.emplace( n2, s );
 
 // 		occurrences of n1
-	for( Sequence& ss: occ( n0 )) {
-		occurrences.emplace( n1, ss );
-	}
+	occurrences.copy( n0, n1 );
 
 	if(( d+dd ) >= minim ) {
 // 	keep n0 occurrences
@@ -282,21 +256,12 @@ void TrieSlice::_add( Source& src, Sequence s, Node n0, Position p, Depth d, Len
 }
 
 void TrieSlice::_mark( Source& src, Sequence s, Node n0, Position p, Depth d, Length l, Length minim ) {
-	Position p0 = position( source.at( n0 ));
-	Length l0   = length( source.at( n0 ));
+	Position p0 = position( store.getSource( n0 ));
+	Length l0   = length( store.getSource( n0 ));
 
-	Depth dd;
-	bool mismatch = false;
-
-	for( dd = 0 ; dd < min( l0, l ) ; dd++ ){
 // 	WARNING: matching between ambiguous symbols ("&" and not "=")
-		if( src.symbol( p0+dd ) & src.symbol( p+dd )){
-			continue;
-		}
-
-		mismatch = true;
-		break;
-	}
+	Depth dd = src.overlapping( p0, p, min( l0, l ));
+	bool mismatch = ( dd < min( l0, l ));
 
 // 	cout << dd << " " << l0 << " " << l << endl;
 
@@ -336,27 +301,13 @@ void TrieSlice::_mark( Source& src, Sequence s, Node n0, Position p, Depth d, Le
 //      s  |-------|                                    +|====|E [s0,...]
 
 		Symbol sy = src.symbol( p0+dd );
-		vector<SymbolNode> c0 = children( n0 );
-
-		for( auto& c: c0 ) {
-			children_hash.erase( symbolNode( symbol( c ), n0 ));
-		}
-		children_list.erase( n0 );
-
-// 	insert n1
-		Node n = newChild( n0, sy, p0+dd, l0-dd );
-		for( auto& c: c0 ) {
-			children_hash.emplace( symbolNode( symbol( c ), n ), node( c ));
-			children_list.emplace( n, c );
-		}
+		Node n = insertChild( n0, sy, p0+dd, l0-dd );
 
 // 	shrink n0
-		source.at( n0 ) = positionLength( p0, dd );
+		store.setSource( n0, positionLength( p0, dd ));
 
 // 		occurrences of n
-		for( Sequence& ss: occ( n0 )) {
-			occurrences.emplace( n, ss );
-		}
+		occurrences.copy( n0, n );
 
 		occurrences.emplace( n0, s );
 		return;
@@ -372,27 +323,13 @@ void TrieSlice::_mark( Source& src, Sequence s, Node n0, Position p, Depth d, Le
 
 // 	only add occurrences to the nodes below the "minimum" depth
 	Symbol sy = src.symbol( p0+dd );
-	vector<SymbolNode> c0 = children( n0 );
-
-	for( auto& c: c0 ) {
-		children_hash.erase( symbolNode( symbol( c ), n0 ));
-	}
-	children_list.erase( n0 );
-
-// 	insert n1
-	Node n = newChild( n0, sy, p0+dd, l0-dd );
-	for( auto& c: c0 ) {
-		children_hash.emplace( symbolNode( symbol( c ), n ), node( c ));
-		children_list.emplace( n, c );
-	}
+	Node n = insertChild( n0, sy, p0+dd, l0-dd );
 
 // 	shrink n0
-	source.at( n0 ) = positionLength( p0, dd );
+	store.setSource( n0, positionLength( p0, dd ));
 
 // 		occurrences of n
-	for( Sequence& ss: occ( n0 )) {
-		occurrences.emplace( n, ss );
-	}
+	occurrences.copy( n0, n );
 
 	occurrences.emplace( n0, s );
 	return;
@@ -412,17 +349,13 @@ void TrieSlice::_mark( Source& src, Sequence s, Node n0, Position p, Depth d, Le
  * \param minim minimum length of an oligonucleotide
  */
 void TrieSlice::_smallDiff1( Source& src, Node n0, Position p, Depth d, Length l, Sequence s, Length minim ) {
-	PositionLength pl0 = source.at( n0 );
+	PositionLength pl0 = store.getSource( n0 );
 	Position p0 = position( pl0 );
 	Length l0   = length( pl0 );
 
-	Depth dd = 0;
-
-	for( dd = 0 ; dd < min( l0, l ) ; dd ++ ) {
-		if( src.symbol( p0+dd ) & src.symbol( p+dd )) {
-			continue;
-		}
+	Depth dd = src.overlapping( p0, p, min( l0, l ));
 
+	if( dd < min( l0, l )) {
 // 	HERE: more than one difference
 		if(( dd > 0 ) && ( d+dd ) >= minim ) {
 
@@ -480,7 +413,7 @@ void TrieSlice::_smallDiff1( Source& src, Node n0, Position p, Depth d, Length l
  * \param minim minimum length of an oligonucleotide
  */
 void TrieSlice::_smallDiff0( Source& src, Node n0, Position p, Depth d, Length l, Sequence s, Length minim ) {
-	PositionLength pl0 = source.at( n0 );
+	PositionLength pl0 = store.getSource( n0 );
 	Position p0 = position( pl0 );
 	Length l0   = length( pl0 );
 
@@ -488,8 +421,9 @@ void TrieSlice::_smallDiff0( Source& src, Node n0, Position p, Depth d, Length l
 	Length diff = 0;
 
 	for( dd = 0 ; dd < min( l0, l ) ; dd ++ ) {
-		if( src.symbol( p0+dd ) & src.symbol( p+dd )) {
-			continue;
+		dd += src.overlapping( p0+dd, p+dd, min( l0, l )-dd ); // skip to the next difference
+		if( dd == min( l0, l )) {
+			break;
 		}
 
 		if( ++diff == 1 ) {
@@ -556,13 +490,13 @@ void TrieSlice::_smallDiff0( Source& src, Node n0, Position p, Depth d, Length l
 }
 
 void TrieSlice::_confirm( Trie& trie, const Source& src, const string& s, Node n0, Sequence re, Position p, Depth d, Length l, Length minim ) {
-	Position p0 = position( source.at( n0 ));
-	Length l0   = length( source.at( n0 ));
+	Position p0 = position( store.getSource( n0 ));
+	Length l0   = length( store.getSource( n0 ));
 
 	Depth dd;
 	bool mismatch = false;
 
-	bool has_cluster = cluster.count( n0 );
+	bool has_cluster = store.hasCluster( n0 );
 
 	for( dd = 0 ; dd < min( l0, l ) ; dd++ ){
 // 	WARNING: matching between ambiguous symbols ("&" and not "=")
@@ -582,8 +516,8 @@ void TrieSlice::_confirm( Trie& trie, const Source& src, const string& s, Node n
 // 	it is safe to add s to the occurrences
 
 		if( !has_cluster ) return; // no cluster == no occurrences
-		if( src.commonSpecies( re, cluster.at( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
-		cluster.erase( n0 );
+		if( src.commonSpecies( re, store.getCluster( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
+		store.eraseCluster( n0 );
 		return;
 	}
 
@@ -595,8 +529,8 @@ void TrieSlice::_confirm( Trie& trie, const Source& src, const string& s, Node n
 
 		if(( d+dd ) >= minim ) {
 			if( !has_cluster ) return; // no cluster == no occurrences
-			if( src.commonSpecies( re, cluster.at( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
-			cluster.erase( n0 );
+			if( src.commonSpecies( re, store.getCluster( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
+			store.eraseCluster( n0 );
 		}
 
 		for( auto& c: children( n0 )) {
@@ -613,28 +547,16 @@ void TrieSlice::_confirm( Trie& trie, const Source& src, const string& s, Node n
 //      s  |-------|                                    +|====|E [s0,...]
 
 		if( !has_cluster ) return; // no cluster == no occurrences
-		if( src.commonSpecies( re, cluster.at( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
+		if( src.commonSpecies( re, store.getCluster( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
 
 		Symbol sy = src.symbol( p0+dd );
-		vector<SymbolNode> c0 = children( n0 );
-
-		for( auto& c: c0 ) {
-			children_hash.erase( symbolNode( symbol( c ), n0 ));
-		}
-		children_list.erase( n0 );
-
-// 	insert n1
-		Node n = newChild( n0, sy, p0+dd, l0-dd );
-		for( auto& c: c0 ) {
-			children_hash.emplace( symbolNode( symbol( c ), n ), node( c ));
-			children_list.emplace( n, c );
-		}
+		Node n = insertChild( n0, sy, p0+dd, l0-dd );
 
 // 	shrink n0
-		source.at( n0 ) = positionLength( p0, dd );
+		store.setSource( n0, positionLength( p0, dd ));
 
 // 		occurrences of n
-		cluster.emplace( n, cluster.at( n0 )); // copy the occurrences
+		store.setCluster( n, store.getCluster( n0 )); // copy the occurrences
 
 		return;
 	}
@@ -647,30 +569,18 @@ void TrieSlice::_confirm( Trie& trie, const Source& src, const string& s, Node n
 	}
 
 	if( !has_cluster ) return; // no cluster == no occurrences
-	if( src.commonSpecies( re, cluster.at( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
+	if( src.commonSpecies( re, store.getCluster( n0 ))) return; // keep this oligo; one of its species matches the species of the reference sequence
 
 // 	only add occurrences to the nodes below the "minimum" depth
 	Symbol sy = src.symbol( p0+dd );
-	vector<SymbolNode> c0 = children( n0 );
-
-	for( auto& c: c0 ) {
-		children_hash.erase( symbolNode( symbol( c ), n0 ));
-	}
-	children_list.erase( n0 );
-
-// 	insert n1
-	Node n = newChild( n0, sy, p0+dd, l0-dd );
-	for( auto& c: c0 ) {
-		children_hash.emplace( symbolNode( symbol( c ), n ), node( c ));
-		children_list.emplace( n, c );
-	}
+	Node n = insertChild( n0, sy, p0+dd, l0-dd );
 
 // 	shrink n0
-	source.at( n0 ) = positionLength( p0, dd );
+	store.setSource( n0, positionLength( p0, dd ));
 
 // 		occurrences of n
-	cluster.emplace( n, cluster.at( n0 ));
-	cluster.erase( n0 );
+	store.setCluster( n, store.getCluster( n0 ));
+	store.eraseCluster( n0 );
 
 	return;
 }
@@ -688,7 +598,7 @@ void TrieSlice::show( const Source& src, Node n, Depth d ) const
 {
 // 	if( n ) {
 // // 		print the contents of a node that is not the TrieSlice root
-// 		cout << src.subsequence( position( source.at( n )), Length( length( source.at( n ))));
+// 		cout << src.subsequence( position( store.getSource( n )), Length( length( store.getSource( n ))));
 // 	}
 // 
 // // 	print occurrences
@@ -711,7 +621,7 @@ void TrieSlice::show( const Source& src, Node n, Depth d ) const
 // 
 // 	if( !n ) {
 // // 	print the contents of the TrieSlice root from the portion accessible from its first child
-// 		cout << src.subsequence( position( source.at( node( ch.front()))) - d, d );
+// 		cout << src.subsequence( position( store.getSource( node( ch.front()))) - d, d );
 // 	}
 // 
 // // 	print children, recursively
@@ -719,7 +629,7 @@ void TrieSlice::show( const Source& src, Node n, Depth d ) const
 // 	bool bc = true;
 // 	for( auto& c:ch ) {
 // 		if(bc){bc = false;} else {cout << " ";}
-// 		show( t, node( c ), Depth( d+length( source.at( n ))));
+// 		show( t, node( c ), Depth( d+length( store.getSource( n ))));
 // 	}
 // 	cout << ")";
 }
@@ -753,20 +663,20 @@ void TrieSlice:: measure(
 	Distribution& depth_distribution, Distribution& length_distribution, Distribution& occurrence_distribution
 ) const {
 	nodes++;
-	if( children_hash.find( n0 ) == children_hash.end()) {
+	if( !store.hasChildren( n0 )) {
 		leaves++;
 	}
 
-	l += length( source.at( n0 ));
+	l += length( store.getSource( n0 ));
 	o += occurrences.count( n0 );
 
 	depth_distribution[d]++; 
-	length_distribution[length( source.at( n0 ) )]++;
+	length_distribution[length( store.getSource( n0 ) )]++;
 	occurrence_distribution[occurrences.count( n0 )]++;
 
 	for( auto& c: children( n0 )) {
 		measure(
-			node( c ), Depth( d+length( source.at( n0 ))),
+			node( c ), Depth( d+length( store.getSource( n0 ))),
 			nodes, leaves, l, o,
 			depth_distribution, length_distribution, occurrence_distribution );
 	}
@@ -791,12 +701,12 @@ void TrieSlice::verify( const Source& src, Node n0 ) const {
 			error( string{"different child found in hash ('"}+nu2asc.at( symbol( c ))+"') than in list" );
 		}
 
-		if( symbol( c ) != src.symbol( position( source.at( node( c ))))) {
+		if( symbol( c ) != src.symbol( position( store.getSource( node( c ))))) {
 			error(
 				string{"list ('"}
 				+nu2asc.at( symbol( c ))
 				+"') vs. source ('"
-				+nu2asc.at(src.symbol( position( source.at( node( c )))))
+				+nu2asc.at(src.symbol( position( store.getSource( node( c )))))
 				+"')"
 			);
 		}
@@ -810,7 +720,7 @@ unordered_multimap<string,Sequence>& TrieSlice::find( const Source& so, const st
 }
 
 unordered_multimap<string,Sequence>& TrieSlice::find( const Source& so, const string& s, Node n0, Depth d, unordered_multimap<string,Sequence>& a ) const {
-	PositionLength pl0 = source.at( n0 );
+	PositionLength pl0 = store.getSource( n0 );
 	Position p0 = position( pl0 );
 	Length l0 = length( pl0 );
 
@@ -854,12 +764,12 @@ Cluster TrieSlice::getClusterId( Source& src, Position p, Length l ) const {
 Cluster TrieSlice::_getClusterId( Source& src, Node n0, Position p, Depth d, Length l ) const {
 	assert( l > 0 );
 
-	Length l0   = length( source.at( n0 ));
+	Length l0   = length( store.getSource( n0 ));
 
 	if( l <= l0 ) {
-		assert( cluster.count( n0 ) > 0 );
+		assert( store.hasCluster( n0 ) > 0 );
 
-		return cluster.at( n0 );
+		return store.getCluster( n0 );
 	}
 
 	Node n;
@@ -879,7 +789,7 @@ const bool TrieSlice::getCluster( const Trie& trie, const string& s, Position p,
 const bool TrieSlice::_getCluster( const Trie& trie, Node n0, Depth d, const string& s, Position p, Length l, Cluster& clu ) const {
 	assert( l > 0 );
 
-	PositionLength pl0 = source.at( n0 );
+	PositionLength pl0 = store.getSource( n0 );
 	Position p0 = position( pl0 );
 	Length l0 = length( pl0 );
 
@@ -892,9 +802,9 @@ const bool TrieSlice::_getCluster( const Trie& trie, Node n0, Depth d, const str
 	}
 
 	if( l <= l0 ) { // the target sequence ends before the current node
-		assert( cluster.count( n0 ) > 0 ); // WARNING: make sure that the length matches --oligo-size
+		assert( store.hasCluster( n0 ) > 0 ); // WARNING: make sure that the length matches --oligo-size
 
-		clu = cluster.at( n0 );
+		clu = store.getCluster( n0 );
 		return true;
 	}
 
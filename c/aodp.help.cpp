@@ -7,6 +7,11 @@ const string Application::_help =
 "SYNOPSIS\n"
 "    aodp [*options*] *output* *fasta-sequence-file...*\n"
 "\n"
+"    aodp --index=*index-file* --match=*target-FASTA-file*\n"
+"    [--match-output=*output-file*]\n"
+"\n"
+"    aodp [*options*] *output* --read-db=*database-file*\n"
+"\n"
 "DESCRIPTION\n"
 "    \"aodp\" generates oligonucleotide signatures for sequences in FASTA\n"
 "    format and for all groups in a phylogeny in the Newick tree format.\n"
@@ -17,6 +22,11 @@ const string Application::_help =
 "    Any command line argument without the prefix \"--\" will be treated as a\n"
 "    file name.\n"
 "\n"
+"    Sequence files (including the --match and --database files) can be\n"
+"    compressed with gzip or bgzip; compressed files are recognized by their\n"
+"    content, not by their name. Blocks of bgzip files are decompressed in\n"
+"    parallel (see --threads).\n"
+"\n"
 "    Each FASTA file can contain multiple sequences. Sequence identifiers are\n"
 "    read from the FASTA description lines (lines starting with \"\">).\n"
 "    Everything on the description line following a space is ignored.\n"
@@ -81,8 +91,9 @@ const string Application::_help =
 "        Requires a --tree-file option and a file-name\n"
 "\n"
 "    --time[=file-name]\n"
-"        Tab-separated \"user\", \"system\", \"elapsed\" time and maximum memory\n"
-"        usage for various phases of processing\n"
+"        Tab-separated \"user\", \"system\", \"elapsed\" time, maximum memory\n"
+"        usage, current memory usage and the change in memory usage for\n"
+"        various phases of processing\n"
 "\n"
 "    --basename=(name)\n"
 "        All oligos in the following formats:\n"
@@ -183,6 +194,9 @@ const string Application::_help =
 "        * Size of the \"maximum-set\" of sequences contained in any clusters\n"
 "          matched by the target sequence\n"
 "\n"
+"        The lines are in the order of the target sequences in the --match\n"
+"        file.\n"
+"\n"
 "        Suggestion: --max-homolo=0 must be specified, otherwise matches\n"
 "        containing homopolymers will be ignored and the match percentage\n"
 "        will be lowered\n"
@@ -192,6 +206,29 @@ const string Application::_help =
 "\n"
 "        Requires a --match input\n"
 "\n"
+"    --index-output=(output-file)\n"
+"        Write the trie of all oligos, after all filtering (including\n"
+"        --database), together with the source sequences and clusters to a\n"
+"        binary index file. Subsequent runs can use the index file with\n"
+"        --index and --match instead of processing the\n"
+"        *fasta-sequence-file*-s again.\n"
+"\n"
+"        Index files are specific to the version of \"aodp\" and to the\n"
+"        architecture of the computer they were written on. Not supported\n"
+"        with --ambiguous-oligos.\n"
+"\n"
+"    --write-db=(output-file)\n"
+"        Write the sequence database to a binary file: the\n"
+"        *fasta-sequence-file*-s, after reading and filtering them for\n"
+"        ambiguities and, if requested, for melting temperatures\n"
+"        (--max-melting). Subsequent runs can read the database file with\n"
+"        --read-db instead of processing the *fasta-sequence-file*-s again.\n"
+"        If the database file is the only output, \"aodp\" stops after writing\n"
+"        it.\n"
+"\n"
+"        Database files are specific to the version of \"aodp\" and to the\n"
+"        architecture of the computer they were written on.\n"
+"\n"
 "OPTIONS\n"
 "    Other command line parameters are optional.\n"
 "\n"
@@ -314,6 +351,35 @@ const string Application::_help =
 "        (\"n\") and will use \"n-1\" threads, or one thread on single processor\n"
 "        systems.\n"
 "\n"
+"    --prefix-depth=(size)\n"
+"        Length of the prefixes used to split the internal search structure\n"
+"        in independent slices (default 4, maximum 8). Longer prefixes\n"
+"        produce up to \"4^size\" smaller slices, which improves parallelism\n"
+"        and memory locality on very large databases. Must be smaller than\n"
+"        the minimum --oligo-size. Does not affect the results.\n"
+"\n"
+"    --index=(index-file)\n"
+"        Read the trie from an index file written with --index-output,\n"
+"        instead of processing *fasta-sequence-file*-s. The index file is\n"
+"        mapped in memory and searched directly, which takes seconds even for\n"
+"        large databases. Only --match is supported (with --match-output,\n"
+"        --threads and --time). The --oligo-size and --prefix-depth are those\n"
+"        used when writing the index.\n"
+"\n"
+"    --read-db=(database-file)\n"
+"        Read the sequence database from a file written with --write-db,\n"
+"        instead of processing *fasta-sequence-file*-s. The --oligo-size,\n"
+"        --max-ambiguities, --max-crowded-ambiguities and\n"
+"        --reverse-complement options must be the same as when writing the\n"
+"        database; so must the --max-melting, --strand and --salt options, if\n"
+"        the database was filtered for melting temperatures. A database\n"
+"        written without --max-melting can be filtered for any melting\n"
+"        temperature. Not supported with --fold for databases that are\n"
+"        already filtered for melting temperatures.\n"
+"\n"
+"        The --tree-file, --outgroup-file and --isolation-file, as well as\n"
+"        all outputs, can change from run to run.\n"
+"\n"
 "    --max-ambiguities=(count)\n"
 "        Indicates the maximum number of ambiguous bases (default 5).\n"
 "        Sequences with more than this number of ambiguous bases will not be\n"
@@ -5,6 +5,8 @@
 #include <iomanip>
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 #include <cassert>
 
@@ -52,21 +54,41 @@ public:
 	};
 
 	/**
-	 * Maximum length of the smallest sequence
+	 * Maximum length of the smallest sequence for the traceback tables (\see AlignmentPrint); longer
+	 * sequences are aligned within a band of diagonals (\see Match::onSequence)
 	 */
 	static const size_t max_length_smallest_sequence = 4096;
 
+	/**
+	 * Number of anti-diagonals between two checks of the upper bound of the match percentage (\see Alignment::_alignBand)
+	 */
+	static const size_t bound_period = 64;
+
 private:
 	static const int ma = +1;
 	static const int mi = -1;
 	static const int ga = -1;
 
 	array<Element,max_length_smallest_sequence> e;
+
+// 	last three anti-diagonals of the dynamic programming table, by row+1 (\see _align): score, matches, overlap length
+	array<vector<int32_t>,3> dS;
+	array<vector<int32_t>,3> dM;
+	array<vector<int32_t>,3> dL;
+
+	string rc; // string in columns, reversed
 public:
-	Element align( const string& s1, const Position p1, const LLength l1, const string& s2, const Position p2, const LLength l2 );
+	/**
+	 * \param least match percentage (100*M/L) to reach: the alignment is abandoned as soon as it cannot
+	 * reach it; an abandoned alignment \returns an Element with L=0 (\see Alignment::_alignBand)
+	 */
+	Element align( const string& s1, const Position p1, const LLength l1, const string& s2, const Position p2, const LLength l2, const double least = 0 );
+	Element align( const string& s1, const Position p1, const LLength l1, const string& s2, const Position p2, const LLength l2, long dlo, long dhi, const double least = 0 );
 
 protected:
-	Element _align( const string& c, const Position pc, const LLength lc, const string& r, const Position pr, const LLength lr );
+	virtual Element _align( const string& c, const Position pc, const LLength lc, const string& r, const Position pr, const LLength lr, const double least );
+	Element _alignBand( const string& c, const Position pc, const LLength lc, const string& r, const Position pr, const LLength lr, long dlo, long dhi, const double least );
+	Element _alignColumns( const string& c, const Position pc, const LLength lc, const string& r, const Position pr, const LLength lr );
 
 	virtual void init( const LLength co, const LLength ro );
 	virtual char match( const LLength i, const LLength j,
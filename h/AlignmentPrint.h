@@ -13,6 +13,7 @@ public:
 	void print( const string& s1, Position p1, LLength l1, const string& s2, Position p2, LLength l2 );
 
 protected:
+	virtual Element _align( const string& c, const Position pc, const LLength lc, const string& r, const Position pr, const LLength lr, const double least );
 	virtual void init( const LLength co, const LLength ro );
 	void _print( const string& c, Position pc, LLength lc, const string& r, Position pr, LLength lr );
 	virtual char match( const LLength i, const LLength j,
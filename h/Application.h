@@ -20,8 +20,12 @@
 
 #include "Trie.h"
 #include "TrieAmbig.h"
+#include "TrieMapped.h"
 #include "Reference.h"
 #include "Match.h"
+#include "SourceDatabase.h"
+#include "OutputBuffer.h"
+#include "ClusterPatterns.h"
 
 class Application
 {
@@ -36,6 +40,11 @@ protected:
 	static const int I_oligo_size_min;
 	static const int I_oligo_size_max;
 
+	/**
+	 * Maximum number of matches (8 bytes each) sorted and written at once when streaming the output (\see streamOutput)
+	 */
+	static const size_t output_batch;
+
 private:
 	/**
 	 * aodp version; defined in c/version.cpp
@@ -57,17 +66,39 @@ private:
 
 	void readSequences();
 
+	/**
+	 * Part of the oligo output files: the targets [target_lo,target_hi) (in the order of Source::getTargets),
+	 * their matches are in Trie::matches
+	 */
+	struct OutputPart {
+		map<set<Sequence>,string>::const_iterator target_lo;
+		map<set<Sequence>,string>::const_iterator target_hi;
+
+		bool first; // first part: headers of the output files (--gff)
+		bool last;  // last part: footers of the output files (--gff)
+
+		unsigned long gff_id; // id of the next oligo in --gff
+	};
+
+	/**
+	 * Ranges of the oligos (\see calculateRanges)
+	 */
+	typedef pair<map<string, map<TypeFragment, Cover<Position>>>,map<TypeFragment, Cover<Position>>> OligoRanges;
+
+	OutputPart wholeOutput( Trie& trie ) const;
+	void streamOutput( Trie& trie );
+
 	void help();
 	void printVersion();
 
-	void printOligoStrings( ostream* o, Trie& trie ) const;
+	void printOligoStrings( ostream* o, Trie& trie, const OutputPart& part ) const;
 
-	void printOligoPositions( ostream* o, Trie& trie ) const;
-	void printOligoRanges( ostream* o, Trie& trie ) const;
+	void printOligoPositions( ostream* o, Trie& trie, const OligoRanges& ra ) const;
+	void printOligoRanges( ostream* o, Trie& trie, const OligoRanges& ra ) const;
 
-	void printFasta( ostream* o, Trie& trie ) const;
-	void printGff( ostream* o, Trie& trie ) const;
-	void printTab( ostream* o, Trie& trie ) const;
+	void printFasta( ostream* o, Trie& trie, const OutputPart& part ) const;
+	void printGff( ostream* o, Trie& trie, OutputPart& part ) const;
+	void printTab( ostream* o, Trie& trie, const OutputPart& part ) const;
 
 	void printNewick( ostream* o, Trie& trie ) const;
 	void printNodeList( ostream* o, Trie& trie ) const;
@@ -89,7 +120,11 @@ private:
 
 // 	TrieT processor;
 
-	pair<map<string, map<Sequence, Cover<Position>>>,map<Sequence, Cover<Position>>> calculateRanges( Trie& trie ) const;
+	vector<pair<const string*,const vector<PositionDepthLength>*>> targetMatches( Trie& trie, const OutputPart& part ) const;
+
+	OligoRanges calculateRanges( Trie& trie, const OutputPart& part ) const;
+	static Cover<Position> mergeRanges( vector<Range<Position>>& v );
+	static void combineRanges( map<TypeFragment, Cover<Position>>& into, map<TypeFragment, Cover<Position>>& from );
 	vector<unsigned long> fillRange( unsigned long lo, unsigned long hi, int first_site_gap, int inter_site_gap );
 
 	string s_first_input_file_name;
@@ -123,8 +158,20 @@ private:
 //	everything else is sequence files
 	vector<string> sequence_files;
 
+// 	whether the sequence database (--write-db) is the only output
+	bool b_database_only = false;
+
+// 	whether the oligo output files are written by parts, by batches of clusters (\see streamOutput)
+	bool b_stream_output = false;
+
 //	Measure duration of steps
 	Clock timer;
+
+	void check( Trie& trie, const string& phase );
+
+// 	largest storage of each of the main structures at the end of any phase, and that phase (--metrics)
+	MemoryBreakdown memory_peak;
+	map<string,string> memory_phase;
 };
 
 #endif
@@ -10,6 +10,8 @@
 
 using namespace std;
 
+#include "Memory.h"
+
 /**
  * Print "maximum resident set size"
  * 
@@ -45,6 +47,9 @@ public:
 
 		s0 = double( t.tms_stime ) / ticks;
 		s1 = s0;
+
+		r0 = resident();
+		r1 = r0;
 	};
 
 	/**
@@ -63,11 +68,18 @@ public:
 		if( !out )
 			return;
 
-		e1=e0; u1 = u0; s1=s0;
+		e1=e0; u1 = u0; s1=s0; r1 = r0;
 		*out << "-----------------------------------------------" << endl;
 		check( message );
 	};
 
+	/**
+	 * \returns the current resident set size of the process in bytes (0 if not available)
+	 * 
+	 * Reference: man proc (/proc/self/statm)
+	 */
+	static long long resident();
+
 	friend ostream& operator << ( ostream& o, Clock& c );
 private:
 	struct rusage r;
@@ -94,6 +106,13 @@ private:
 	 */
 	double s0, s1;
 
+	/**
+	 * Resident set size in bytes
+	 * 
+	 * Start of clock; start of current operation
+	 */
+	long long r0, r1;
+
 	ostream* out;
 	static const long ticks;
 };
@@ -0,0 +1,61 @@
+#ifndef __ClusterPatterns_h__
+#define __ClusterPatterns_h__
+
+#include <vector>
+#include <map>
+
+using namespace std;
+
+#include "Types.h"
+
+/**
+ * Inclusion analysis of "cluster patterns" (sorted lists of the clusters containing a sequence; \see --sequence-clusters)
+ * 
+ * For each pattern: how many patterns are the same, and how many are included in it ("hidden" by it)
+ * 
+ * Same patterns are analysed once. Inclusion is tested only for the candidate patterns whose first
+ * cluster is in the pattern, against a dense bitset of the clusters of the pattern: linear in the size
+ * of the candidates, not in the number of patterns. Patterns are analysed in parallel
+ */
+class ClusterPatterns {
+private:
+	vector<size_t> distinct; // index of the distinct pattern of each pattern
+	vector<size_t> same;     // number of patterns equal to each distinct pattern
+	vector<size_t> included; // number of patterns included in each distinct pattern
+
+public:
+	/**
+	 * Analyse \param patterns (each sorted, without duplicates) on \param threads threads
+	 */
+	ClusterPatterns( const vector<vector<Cluster>>& patterns, unsigned int threads );
+
+	/**
+	 * Number of patterns equal to pattern \param i (including \param i)
+	 */
+	inline size_t equal( size_t i ) const { return same.at( distinct.at( i )); };
+
+	/**
+	 * Number of patterns included in pattern \param i (including \param i and the empty patterns)
+	 */
+	inline size_t hidden( size_t i ) const { return included.at( distinct.at( i )); };
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
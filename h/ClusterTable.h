@@ -0,0 +1,105 @@
+#ifndef __ClusterTable_h__
+#define __ClusterTable_h__
+
+#include <vector>
+#include <array>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+
+using namespace std;
+
+#include "util.h"
+#include "Relation.h"
+
+#include "Types.h"
+
+/**
+ * Concurrent interning table for clusters (sorted lists of Sequences), used while encoding clusters
+ * 
+ * Lists are spread over shards by their hash; each shard has its own lock, so that slices can intern
+ * their clusters in parallel. Interning returns a provisional id (index in the shard, and shard).
+ * Once all clusters are interned, rank assigns the final cluster ids: the rank of each list in
+ * lexicographic order, i.e. the order of the [sorted] set of Sequence sets
+ * 
+ * NOTE: final ids do not depend on the number of threads, or on the order of interning
+ */
+class ClusterTable {
+private:
+	static const unsigned int shard_bits = 6;
+	static const unsigned int shards = 1U << shard_bits;
+
+	/**
+	 * Hash of a sorted list of Sequences
+	 */
+	struct ListHash {
+		inline size_t operator() ( const vector<Sequence>& l ) const {
+			uint64_t h = 0xcbf29ce484222325ULL ^ l.size(); // FNV-1a over the Sequences
+			for( Sequence s: l ) {
+				h = ( h ^ s ) * 0x100000001b3ULL;
+			}
+
+// 	final mix: all bits of the hash depend on all Sequences (shard is taken from the high bits)
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			return size_t( h );
+		};
+	};
+
+	struct Shard {
+		mutex lock;
+		unordered_map<vector<Sequence>,Cluster,ListHash> index; // list -> index in lists
+		vector<const vector<Sequence>*> lists;                   // in the order of interning (keys of index)
+		vector<Cluster> ids;                                     // final id of each list (after rank)
+	};
+
+	array<Shard,shards> shard;
+
+public:
+	/**
+	 * \returns the provisional id of the cluster made of the sorted, unique Sequences of \param l
+	 * (added if not already there)
+	 * 
+	 * NOTE: thread safe
+	 */
+	Cluster intern( const vector<Sequence>& l );
+
+	/**
+	 * Assign final cluster ids, in lexicographic order of the lists, and add all clusters
+	 * to \param clusters (expected empty)
+	 */
+	void rank( unsigned int threads, One2One<set<Sequence>,Cluster>& clusters );
+
+	/**
+	 * \returns the final id of the cluster with provisional id \param c (\see rank)
+	 */
+	inline Cluster at( Cluster c ) const {
+		return shard[ c & ( shards-1 )].ids[ c >> shard_bits ];
+	};
+
+	/**
+	 * Remove all clusters; releases the storage
+	 */
+	void clear();
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -0,0 +1,72 @@
+#ifndef __Gunzip_h__
+#define __Gunzip_h__
+
+#include <string>
+#include <functional>
+
+using namespace std;
+
+/**
+ * Decompression of gzip input, including BGZF (the blocked gzip format of bgzip and samtools)
+ * 
+ * Decompression is pipelined: a reader thread decompresses the input while the calling thread
+ * consumes the decompressed data (\param sink), in order. BGZF blocks are independent of each other:
+ * batches of blocks are decompressed in parallel on the thread pool, with the reader thread taking part:
+ * decompression goes on even when no thread of the pool is free (e.g. the calling thread is a task of the pool)
+ * 
+ * Errors in the reader thread (corrupt or truncated input) are re-thrown in the calling thread
+ */
+class Gunzip {
+public:
+	/**
+	 * Consumer of decompressed data: \param p, \param n bytes
+	 */
+	typedef function<void( const char* p, size_t n )> Sink;
+
+	/**
+	 * \returns whether the \param n bytes at \param p start with a gzip header
+	 */
+	static bool isGzip( const char* p, size_t n );
+
+	/**
+	 * \returns size of the BGZF block starting at \param p (at most \param n bytes available),
+	 * 0 if \param p does not start with a BGZF block header
+	 */
+	static size_t bgzfBlock( const char* p, size_t n );
+
+	/**
+	 * Decompress the \param n bytes at \param data (e.g. a mapped file), using up to \param threads
+	 * threads for BGZF blocks
+	 * 
+	 * \param path only used in error messages
+	 */
+	static void memory( const string& path, const char* data, size_t n, unsigned int threads, const Sink& sink );
+
+	/**
+	 * Decompress the \param n bytes at \param head (already read), followed by the rest of the
+	 * file descriptor \param fd (e.g. a pipe); always decompressed sequentially
+	 * 
+	 * \param path only used in error messages
+	 */
+	static void stream( const string& path, const char* head, size_t n, int fd, const Sink& sink );
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -0,0 +1,168 @@
+#ifndef __IndexFile_h__
+#define __IndexFile_h__
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Error.h"
+
+using namespace std;
+
+/**
+ * Binary files written by aodp and read back with mmap (\see TrieIndex, SourceDatabase)
+ * 
+ * Layout: 64-bit values and arrays (size, then elements) padded to 8 bytes: every section starts 8-byte aligned
+ * 
+ * WARNING: the files are in native byte order; they are not portable between architectures with different byte orders
+ */
+
+/**
+ * Sequential writer of a binary file
+ */
+class IndexWriter {
+private:
+	ostream& out;
+	uint64_t offset;
+
+	inline void bytes( const void* p, size_t n ) {
+		out.write( static_cast<const char*>( p ), n );
+		offset += n;
+	};
+
+public:
+	IndexWriter( ostream& o ): out( o ), offset( 0 ) {};
+
+	inline void value( uint64_t v ) { bytes( &v, sizeof( v )); };
+
+	template<class T> inline void block( const T* p, uint64_t n ) {
+		static const char zero[8] = {};
+
+		value( n );
+		bytes( p, n * sizeof( T ));
+		bytes( zero, ( 8 - offset % 8 ) % 8 );
+	};
+
+	inline void text( const string& s ) { block( s.data(), s.size()); };
+
+	inline bool good() const { return out.good(); };
+};
+
+/**
+ * Sequential reader of a binary file mapped in memory (\see IndexWriter)
+ * 
+ * \param what kind of file, for error messages (e.g. "index file")
+ */
+class IndexReader {
+private:
+	const string what;
+	const string& path;
+	const char* const begin;
+	const char* p;
+	const char* const end;
+
+	/**
+	 * Check that \param n elements of \param s bytes are left
+	 * 
+	 * NOTE: n * s is not computed: it overflows for corrupt sizes
+	 */
+	inline void need( uint64_t n, size_t s = 1 ) const {
+		if( n > uint64_t( end-p ) / s ) error( "corrupt or truncated "+what+" (", path, ")" );
+	};
+
+public:
+	IndexReader( const string& wh, const string& pa, const char* b, size_t o, const char* e ): what( wh ), path( pa ), begin( b ), p( b+o ), end( e ) {};
+
+	inline size_t offset() const { return p - begin; };
+
+	inline uint64_t value() {
+		uint64_t v;
+		need( sizeof( v ));
+		memcpy( &v, p, sizeof( v ));
+		p += sizeof( v );
+		return v;
+	};
+
+	/**
+	 * \returns pointer to the \param n elements of the next array, in place
+	 */
+	template<class T> inline const T* block( uint64_t& n ) {
+		n = value();
+		need( n, sizeof( T ));
+
+		const T* r = reinterpret_cast<const T*>( p );
+		p += n * sizeof( T );
+
+		const size_t pad = ( 8 - offset() % 8 ) % 8;
+		need( pad );
+		p += pad;
+
+		return r;
+	};
+
+	inline string text() {
+		uint64_t n;
+		const char* s = block<char>( n );
+		return string( s, n );
+	};
+};
+
+/**
+ * Read-only mapping of a whole binary file, unmapped on destruction
+ * 
+ * \param what kind of file, for error messages (e.g. "index file")
+ */
+class IndexMapping {
+public:
+	const char* data;
+	size_t size;
+
+	IndexMapping( const string& what, const string& path ): data( nullptr ), size( 0 ) {
+		const int fd = open( path.c_str(), O_RDONLY );
+		if( fd < 0 ) error( "cannot open "+what+" (", path, "): ", strerror( errno ));
+
+		struct stat st;
+		if( fstat( fd, &st ) < 0 ) {
+			close( fd );
+			error( "cannot open "+what+" (", path, "): ", strerror( errno ));
+		}
+
+		size = st.st_size;
+		void* m = size ? mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED;
+		close( fd ); // NOTE: the mapping stays valid
+
+		if( m == MAP_FAILED ) error( "cannot map "+what+" (", path, ")" );
+		data = static_cast<const char*>( m );
+	};
+	~IndexMapping() { if( data ) munmap( const_cast<char*>( data ), size ); };
+
+	IndexMapping( const IndexMapping& ) = delete;
+	IndexMapping& operator= ( const IndexMapping& ) = delete;
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
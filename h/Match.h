@@ -4,31 +4,58 @@
 #include <iostream>
 
 #include <unordered_map>
+#include <map>
 #include <deque>
 #include <array>
 #include <string>
+#include <sstream>
 
 #include <mutex>
+#include <condition_variable>
 
 #include "TrieSlice.h"
 #include "Trie.h"
 #include "util.h"
 #include "Alignment.h"
+#include "SequenceBitmap.h"
 
 /**
  * Finds cluster matches in a Trie to entries in a FASTA file, then compares the source with the target sequence
+ * 
+ * The sequences of the FASTA file (queries) go through a pipeline: the parser reads them into a queue, classifier
+ * workers take them from the queue and the result lines are written in the order of the queries (reorder buffer).
+ * At most match_buffer_size queries are between the parser and the output at any time
  */
 class Match : public ParserFasta {
 public:
 	Match( ostream& o, unsigned int thr, Trie& t, const Length l, bool rc = false ) :
 		ParserFasta ( rc ), out( o ), threads( thr ), 
 		match_buffer_size( max( thr * 4U, 256U )),
-		trie( t ), le( l ) {};
+		trie( t ), le( l ) { indexClusters(); groupFragments(); };
+
+	/**
+	 * Match the sequences of the FASTA file at \param path, on \param thr threads
+	 * 
+	 * The parser runs on the calling thread (\see ParserFasta::parse), which classifies queries too; the other
+	 * classifiers run on the threads of the pool
+	 */
+	virtual void parse( const string& path, unsigned int thr = 1 );
 protected:
 	virtual void onFragment( const string& na, const string& fn, const Cover<Position>& amb, const bool rc = false );
-	virtual void onFinish();
 private:
-	inline void processFragments();
+	/**
+	 * Sequence of the FASTA file, with its own copy of the content (positions from 0)
+	 */
+	struct Query {
+		size_t index; // in the order of the file
+		string na;
+		string s;
+		Cover<Position> amb;
+	};
+
+	void classifierLoop( Alignment& al );
+	void classify( const Query& q, Alignment& al );
+	void stop( bool failed );
 	inline ostream& print(
 		ostream& out,
 
@@ -42,17 +69,37 @@ private:
 		const LLength min_set_size,
 		const LLength max_set_size = 0
 	);
-	void sequenceLoop( bool& first );
-	void onSequence( const string& na, const Cover<Position>& amb, Alignment& al );
+	void onSequence( ostream& out, const Query& q, Alignment& al );
+	bool band( const deque<pair<Position,Cluster>>& po_cluster, const Sequence se, const string& co, const string& s, const Position lo, long& dlo, long& dhi ) const;
+	void indexClusters();
+	void groupFragments();
+
+	static const long band_margin = 256; // diagonals added on each side of the band of a long alignment
 
 	ostream& out; // output stream
 	const unsigned int threads;
-	const unsigned int match_buffer_size;
+	const unsigned int match_buffer_size; // maximum number of queries read and not yet written
 
 	Trie& trie;
 	const Length le;
 
-	deque<pair<string,Cover<Position>>> match_sequences;
+	mutex lock; // protects the state of the pipeline (below)
+	condition_variable wake_classifiers; // a query is waiting, or the end of the queries
+	condition_variable wake_parser;      // a query was written
+
+	deque<Query> queries;       // read, waiting for a classifier
+	map<size_t,string> results; // classified, waiting for the results of earlier queries (reorder buffer)
+	size_t next_query = 0;      // index of the next query read
+	size_t next_result = 0;     // index of the next query written
+	bool b_closed = false;      // no more queries
+	bool b_failed = false;      // a classifier failed: the pipeline stops
+
+	Alignment parser_alignment; // alignments of the queries classified by the parser thread (\see onFragment)
+
+	vector<SequenceBitmap> cluster_sequences; // Sequences of each Cluster of the source (\see indexClusters)
+	Sequence sequences = 0;                   // all Sequences of the clusters are below
+
+	unordered_map<TypeFragment,TypeFragment> same_fragment; // for each fragment of the source: the first fragment with the same content
 };
 
 #endif
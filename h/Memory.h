@@ -0,0 +1,122 @@
+#ifndef __Memory_h__
+#define __Memory_h__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Amount of memory, printed in the largest unit that keeps it above 1 (B, KiB, MiB, GiB)
+ * 
+ * \param delta print the sign (for differences)
+ */
+struct Bytes {
+	long long n;
+	bool delta;
+
+	Bytes( long long b, bool d = false ): n( b ), delta( d ) {};
+};
+
+inline ostream& operator<< ( ostream& o, const Bytes& b ) {
+	if( b.delta ) o << (( b.n < 0 ) ? '-' : '+' );
+
+	const unsigned long long n = ( b.n < 0 ) ? -b.n : b.n;
+
+	if( n >= 1073741824ULL ) return o << n / 1073741824ULL << " GiB";
+	if( n >= 1048576ULL ) return o << n / 1048576ULL << " MiB";
+	if( n >= 1024ULL ) return o << n / 1024ULL << " KiB";
+
+	return o << n << " B";
+}
+
+/**
+ * Named amounts of memory, for reporting (\see Trie::memory)
+ */
+typedef map<string,size_t> MemoryBreakdown;
+
+/**
+ * Approximate heap storage (bytes) used by an object, including the storage of its elements
+ * 
+ * NOTE: node sizes follow libstdc++: tree nodes (set, map) have three pointers and a color
+ *       besides the element; hash nodes (unordered_map) have a pointer to the next node
+ */
+const size_t tree_node_overhead = 4 * sizeof( void* );
+const size_t hash_node_overhead = sizeof( void* );
+
+template<class T> inline size_t footprint( const T& );
+inline size_t footprint( const string& s );
+template<class T1, class T2> inline size_t footprint( const pair<T1,T2>& p );
+template<class T> inline size_t footprint( const vector<T>& v );
+template<class T> inline size_t footprint( const deque<T>& d );
+template<class T> inline size_t footprint( const set<T>& s );
+template<class K, class V> inline size_t footprint( const map<K,V>& m );
+template<class K, class V, class H> inline size_t footprint( const unordered_map<K,V,H>& m );
+
+template<class T> inline size_t footprint( const T& ) {
+	return 0; // scalars and other objects without heap storage
+}
+
+inline size_t footprint( const string& s ) {
+	return ( s.capacity() > 15 ) ? s.capacity()+1 : 0; // short strings are stored in place
+}
+
+template<class T1, class T2> inline size_t footprint( const pair<T1,T2>& p ) {
+	return footprint( p.first ) + footprint( p.second );
+}
+
+template<class T> inline size_t footprint( const vector<T>& v ) {
+	size_t r = v.capacity() * sizeof( T );
+	for( const T& e: v ) r += footprint( e );
+	return r;
+}
+
+template<class T> inline size_t footprint( const deque<T>& d ) {
+	size_t r = d.size() * sizeof( T );
+	for( const T& e: d ) r += footprint( e );
+	return r;
+}
+
+template<class T> inline size_t footprint( const set<T>& s ) {
+	size_t r = s.size() * ( tree_node_overhead + sizeof( T ));
+	for( const T& e: s ) r += footprint( e );
+	return r;
+}
+
+template<class K, class V> inline size_t footprint( const map<K,V>& m ) {
+	size_t r = m.size() * ( tree_node_overhead + sizeof( pair<const K,V> ));
+	for( const auto& e: m ) r += footprint( e.first ) + footprint( e.second );
+	return r;
+}
+
+template<class K, class V, class H> inline size_t footprint( const unordered_map<K,V,H>& m ) {
+	size_t r = m.bucket_count() * sizeof( void* ) + m.size() * ( hash_node_overhead + sizeof( pair<const K,V> ));
+	for( const auto& e: m ) r += footprint( e.first ) + footprint( e.second );
+	return r;
+}
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
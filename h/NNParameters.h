@@ -38,8 +38,15 @@ using namespace std;
  */
 class NNParameters {
 public:
-	NNParameters() : _initiation( 0 ), _terminal_at_penalty( 0 ), _symmetry_correction( 0 ) {
+	NNParameters() : _initiation( 0 ), _terminal_at_penalty( 0 ), _symmetry_correction( 0 ), _hairpin_at_penalty( 0 ) {
 		_nn.fill( 0 );
+		_terminal_mismatch.fill( 0 );
+		_loop.fill( 0 );
+		_bulge.fill( 0 );
+		_hairpin.fill( 0 );
+
+		_dangx.fill( 0 );
+		_dangy.fill( 0 );
 	};
 
 	/**
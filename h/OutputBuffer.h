@@ -0,0 +1,112 @@
+#ifndef __OutputBuffer_h__
+#define __OutputBuffer_h__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include "Types.h"
+#include "PackedSequence.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Text buffer for the output files: the same formatting as an ostream (strings, characters and
+ * decimal integers), without locales, without flushes
+ */
+class OutputBuffer {
+private:
+	string b;
+
+public:
+	inline OutputBuffer& operator<< ( const string& s ) { b.append( s ); return *this; };
+	inline OutputBuffer& operator<< ( const char* s ) { b.append( s ); return *this; };
+	inline OutputBuffer& operator<< ( char c ) { b.push_back( c ); return *this; };
+
+	template<class T> inline typename enable_if<is_integral<T>::value,OutputBuffer&>::type operator<< ( T v ) {
+		static_assert( sizeof( T ) > 1, "OutputBuffer: an ostream prints single-byte integers as characters" );
+
+		char d[24];
+		char* e = d + sizeof( d );
+		char* p = e;
+
+		typename make_unsigned<T>::type u = v;
+		if( v < 0 ) u = -u;
+
+		do {
+			*--p = '0' + u % 10;
+			u /= 10;
+		} while( u );
+
+		if( v < 0 ) *--p = '-';
+
+		b.append( p, e );
+		return *this;
+	};
+
+	/**
+	 * Append the \param l nucleotides of \param s starting at \param p, printable (\see Source::printableSubsequence)
+	 */
+	inline OutputBuffer& subsequence( const PackedSequence& s, Position p, Position l ) {
+		for( Position i = 0 ; i < l ; i++ ) {
+			b.push_back( nu2asc[ s[ p+i ]]);
+		}
+		return *this;
+	};
+
+	inline size_t size() const { return b.size(); };
+
+	/**
+	 * Write the content of the buffer to \param out and empty the buffer (the storage is kept)
+	 */
+	inline void flush( ostream& out ) {
+		out.write( b.data(), b.size());
+		b.clear();
+	};
+};
+
+/**
+ * Write to \param out the \param n blocks rendered by \param render( i, b ) into OutputBuffer b
+ * 
+ * Blocks are rendered in parallel on \param threads threads, by batches, and written in the order
+ * of their indexes, one write() per block
+ */
+template<class F> inline void printBlocks( ostream& out, unsigned int threads, size_t n, F render ) {
+	const size_t batch = 64 * max( threads, 1U ); // NOTE: only the blocks of a batch are in memory at once
+
+	vector<OutputBuffer> buffers( min( batch, n ));
+
+	for( size_t lo = 0 ; lo < n ; lo += batch ) {
+		const size_t k = min( batch, n-lo );
+
+		parallelFor( threads, k, [&]( size_t i ) {
+			render( lo+i, buffers[i] );
+		});
+
+		for( size_t i = 0 ; i < k ; i++ ) {
+			buffers[i].flush( out );
+		}
+	}
+}
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -0,0 +1,250 @@
+#ifndef __PackedSequence_h__
+#define __PackedSequence_h__
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+#include "Types.h"
+#include "Memory.h"
+
+using namespace std;
+
+/**
+ * Packed storage of a string of 4-bit nucleotides (\see asc2nu), e.g. the Source content
+ * 
+ * Unambiguous nucleotides take 2 bits each (\see nu2pre), 32 to a 64-bit word. Ambiguous nucleotides
+ * are kept in a sparse side-table, by runs: the runs are the ranges of the ambiguity Covers of the
+ * fragments. Words next to ambiguous nucleotides are flagged: the side-table is only searched for
+ * positions in flagged words
+ * 
+ * Reads have the same meaning as for the unpacked string (operator[], at, substr-like unpack)
+ */
+class PackedSequence {
+private:
+	/**
+	 * Run of consecutive ambiguous nucleotides
+	 */
+	struct AmbiguousRun {
+		Position lo;     // first position of the run
+		Position hi;     // position after the last one of the run
+		Position offset; // position of the first nucleotide of the run in ambiguous
+	};
+
+	vector<uint64_t> words;    // 2-bit unambiguous nucleotides; 0 at ambiguous positions; one more word at the end
+	vector<uint64_t> flags;    // one bit for each word: whether the word or the next one has ambiguous nucleotides
+	vector<AmbiguousRun> runs; // in increasing order of their positions
+	string ambiguous;          // nucleotides of all runs, in order
+
+	Position n = 0; // number of nucleotides
+
+	inline Symbol unambiguousAt( Position p ) const {
+		return Symbol( 1 ) << (( words[ p >> 5 ] >> ( 2*( p & 31 ))) & 0x3 ); // same as pre2nu
+	};
+
+	inline bool flagged( Position p ) const {
+		const Position w = p >> 5;
+		return ( flags[ w >> 6 ] >> ( w & 63 )) & 1;
+	};
+
+	/**
+	 * Load in \param v the 32 nucleotides (2 bits each) starting at \param p (they span at most two words)
+	 * 
+	 * \returns false if some of them may be ambiguous (\param v is not usable)
+	 */
+	inline bool window( Position p, uint64_t& v ) const {
+		if( flagged( p )) return false;
+
+		v = load( p );
+		return true;
+	};
+
+	/**
+	 * \returns the 32 nucleotides (2 bits each) starting at \param p (0 for ambiguous ones)
+	 */
+	inline uint64_t load( Position p ) const {
+		const Position w = p >> 5;
+		const unsigned int sh = 2*( p & 31 );
+
+		return sh ? ( words[w] >> sh ) | ( words[w+1] << ( 64-sh )) : words[w];
+	};
+
+	/**
+	 * \returns mask of the 2-bit nucleotides of a window, for the first \param l of them
+	 */
+	static inline uint64_t mask( Position l ) {
+		return ( l < 32 ) ? ( uint64_t( 1 ) << ( 2*l )) - 1 : ~uint64_t( 0 );
+	};
+
+	/**
+	 * Length of the longest prefix of the \param l nucleotides at \param a and at \param b where
+	 * the nucleotides are the same (or overlap, if \param overlap: have a common 4-bit nucleotide)
+	 * 
+	 * NOTE: unambiguous nucleotides overlap only if they are the same: 32 of them are compared at once
+	 */
+	inline Position prefix( Position a, Position b, Position l, const bool overlap ) const {
+		uint64_t x, y;
+		if(( l <= 32 ) && window( a, x ) && window( b, y )) { // NOTE: most comparisons (trie nodes) are short
+			const uint64_t d = ( x ^ y ) & mask( l );
+			return d ? __builtin_ctzll( d ) / 2 : l;
+		}
+
+		Position i = 0;
+
+		while( i < l ) {
+			const Position k = min( l-i, Position( 32 ));
+
+			if( window( a+i, x ) && window( b+i, y )) {
+				const uint64_t d = ( x ^ y ) & mask( k );
+				if( d ) return i + __builtin_ctzll( d ) / 2;
+
+				i += k;
+				continue;
+			}
+
+			for( const Position e = i+k ; i < e ; i++ ) { // some of the nucleotides may be ambiguous
+				const Symbol sa = operator[]( a+i );
+				const Symbol sb = operator[]( b+i );
+
+				if( overlap ? !( sa & sb ) : ( sa != sb )) return i;
+			}
+		}
+
+		return l;
+	};
+
+	/**
+	 * Nucleotide at position \param p of a flagged word (not necessarily ambiguous)
+	 */
+	Symbol ambiguousAt( Position p ) const {
+		auto r = upper_bound( runs.begin(), runs.end(), p, []( Position q, const AmbiguousRun& a ) { return q < a.lo; });
+		if(( r == runs.begin()) || ( p >= (--r)->hi )) {
+			return unambiguousAt( p );
+		}
+
+		return ambiguous[ r->offset + p - r->lo ];
+	};
+
+	friend size_t footprint( const PackedSequence& s );
+	friend class SourceDatabase; // stores the packed arrays as they are
+	friend class TrieIndex;      // same
+public:
+	inline Position size() const { return n; };
+	inline bool empty() const { return !n; };
+
+	inline Symbol operator[]( Position p ) const {
+		return flagged( p ) ? ambiguousAt( p ) : unambiguousAt( p );
+	};
+
+	inline Symbol at( Position p ) const {
+		if( p >= n ) throw out_of_range( "PackedSequence::at" );
+		return operator[]( p );
+	};
+
+	/**
+	 * Append the \param l 4-bit nucleotides at \param s
+	 */
+	void append( const char* s, size_t l ) {
+		words.resize(( size_t( n ) + l + 31 ) / 32 + 1, 0 );
+		flags.resize(( words.size() + 63 ) / 64, 0 );
+
+		for( size_t i = 0 ; i < l ; i++, n++ ) {
+			const Symbol pre = nu2pre[ Symbol( s[i] ) & 0xF ];
+
+			if( pre > 3 ) { // ambiguous: extend the last run or start a new one
+				if( runs.empty() || ( runs.back().hi != n )) {
+					runs.push_back( AmbiguousRun{ n, n, Position( ambiguous.size()) });
+				}
+				runs.back().hi++;
+				ambiguous += s[i];
+
+				const Position w = n >> 5;
+				flags[ w >> 6 ] |= uint64_t( 1 ) << ( w & 63 );
+				if( w ) flags[( w-1 ) >> 6 ] |= uint64_t( 1 ) << (( w-1 ) & 63 );
+				continue;
+			}
+
+			words[ n >> 5 ] |= uint64_t( pre ) << ( 2*( n & 31 ));
+		}
+	};
+	inline void append( const string& s ) {
+		append( s.data(), s.size());
+	};
+
+	/**
+	 * \returns the (unpacked) \param l nucleotides starting at \param p; fewer at the end (same as string::substr)
+	 */
+	string unpack( Position p, Position l ) const {
+		if( p > n ) throw out_of_range( "PackedSequence::unpack" );
+		l = min( l, n-p );
+
+		string r( l, 0 );
+		for( Position i = 0 ; i < l ; i++ ) {
+			r[i] = operator[]( p+i );
+		}
+
+		return r;
+	};
+
+	/**
+	 * \returns the number of leading nucleotides that are the same in the \param l nucleotides
+	 * starting at \param a and in the ones starting at \param b
+	 */
+	inline Position common( Position a, Position b, Position l ) const {
+		return prefix( a, b, l, false );
+	};
+
+	/**
+	 * \returns the number of leading nucleotides that overlap (x & y) in the \param l nucleotides
+	 * starting at \param a and in the ones starting at \param b
+	 */
+	inline Position overlapping( Position a, Position b, Position l ) const {
+		return prefix( a, b, l, true );
+	};
+
+	/**
+	 * Compare the \param l nucleotides starting at \param a with the ones starting at \param b
+	 * 
+	 * \returns <0, 0 or >0 (same order as memcmp on the unpacked nucleotides)
+	 */
+	int compare( Position a, Position b, Position l ) const {
+		const Position i = common( a, b, l );
+		if( i == l ) return 0;
+
+		return ( operator[]( a+i ) < operator[]( b+i )) ? -1 : 1;
+	};
+
+	void clear() {
+		vector<uint64_t>().swap( words );
+		vector<uint64_t>().swap( flags );
+		vector<AmbiguousRun>().swap( runs );
+		string().swap( ambiguous );
+		n = 0;
+	};
+};
+
+inline size_t footprint( const PackedSequence& s ) {
+	return footprint( s.words ) + footprint( s.flags ) + footprint( s.runs ) + footprint( s.ambiguous );
+}
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
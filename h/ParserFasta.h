@@ -14,11 +14,6 @@
 
 using namespace std;
 
-class ParserFasta;
-
-extern int  fasta_parse( ParserFasta&, const string& );
-extern void fasta_restart( FILE* );
-
 class ParserFasta {
 private:
 	const bool b_reverse_complement = false; // whether to generate the reverse complement of sequences in the FASTA file being read
@@ -84,9 +79,18 @@ protected:
 	 * \param rc  whether the fragment comes from the reverse complement of the sequence
 	 */
 	virtual void onFragment( const string& na, const string& fn, const Cover<Position>& amb, const bool rc = false ) = 0;
+
+	/**
+	 * Event listener for the start of a file: at most \param n bytes will be added to the content
+	 * 
+	 * Derived classes that keep the content of whole files may reserve the storage here
+	 */
+	virtual void onReserve( size_t n ) {};
 public:
 	ParserFasta( const bool rc = false ) : b_reverse_complement( rc ), lo( 0 ) {};
 
+	inline bool isReverseComplement() const { return b_reverse_complement; };
+
 	/**
 	 * Encounter a fragment name (event listener)
 	 */
@@ -133,29 +137,15 @@ public:
 	};
 
 	/**
-	 * Interface with the FASTA flex/bison parser
+	 * Read the FASTA file at \param path (\see FastaScanner in ParserFasta.cpp)
+	 * 
+	 * Regular files are mapped in memory (no copy); other files (e.g. pipes) are read in blocks.
+	 * Files compressed with gzip or bgzip are decompressed while being read; BGZF blocks are
+	 * decompressed in parallel on \param threads threads (\see Gunzip)
 	 * 
-	 * The parser will call the event listeners
+	 * The scanner will call the event listeners
 	 */
-	virtual void parse( const string& path ) {
-		FILE* fasta_in = fopen( path.c_str(), "rt" );
-
-		if( !fasta_in ) {
-			error( "cannot open sequence file ( ", path, " )" );
-		}
-
-// 	connect flex to open input file
-		fasta_restart( fasta_in );
-
-// 	bison parser call
-		if( fasta_parse( *this, path )) {
-// 	NOTE: yyparse will return 0 when everything is ok; 1 on YYABORT; 2 on memory exhaustion
-// 	reference: http://www.gnu.org/software/bison/manual/html_node/Parser-Function.html
-			error( "cannot parse sequence file ( ", path, " )" );
-		}
-
-		fclose( fasta_in );
-	};
+	virtual void parse( const string& path, unsigned int threads = 1 );
 };
 
 #endif
@@ -0,0 +1,155 @@
+#ifndef __SequenceBitmap_h__
+#define __SequenceBitmap_h__
+
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include <cstdint>
+#include <cassert>
+
+using namespace std;
+
+#include "Types.h"
+
+/**
+ * Compressed bitmap of a set of Sequences: the non-zero 64-bit words of the dense bitmap (Sequence se
+ * is bit se%64 of word se/64), in increasing order of their index, with the cardinality cached
+ * 
+ * \see SequenceSet for the dense bitmap
+ */
+class SequenceBitmap {
+private:
+	vector<uint32_t> index; // word index, increasing
+	vector<uint64_t> bits;  // word
+	size_t n = 0;           // number of Sequences
+
+	friend class SequenceSet;
+
+	inline void push( uint32_t i, uint64_t w ) {
+		index.push_back( i );
+		bits.push_back( w );
+		n += __builtin_popcountll( w );
+	};
+
+public:
+	SequenceBitmap() {};
+	SequenceBitmap( const set<Sequence>& s ) {
+		for( Sequence se: s ) {
+			const uint32_t i = se / 64;
+			if( index.empty() || ( index.back() != i )) {
+				index.push_back( i );
+				bits.push_back( 0 );
+			}
+			bits.back() |= uint64_t( 1 ) << ( se % 64 );
+		}
+		n = s.size();
+	};
+
+	inline size_t size() const { return n; };
+	inline bool empty() const { return !n; };
+
+	inline bool has( Sequence se ) const {
+		const auto it = lower_bound( index.begin(), index.end(), uint32_t( se / 64 ));
+		return ( it != index.end()) && ( *it == se / 64 ) && (( bits[ it - index.begin()] >> ( se % 64 )) & 1 );
+	};
+
+	/**
+	 * Replace the content with the Sequences in both \param a and \param b (the storage is kept)
+	 * 
+	 * NOTE: linear in the size of \param a, logarithmic in the size of \param b: \param a should be the smaller
+	 */
+	inline void intersect( const SequenceBitmap& a, const SequenceBitmap& b ) {
+		assert(( this != &a ) && ( this != &b ));
+
+		index.clear();
+		bits.clear();
+		n = 0;
+
+		auto j = b.index.begin();
+		for( size_t i = 0 ; i < a.index.size() ; i++ ) {
+			j = lower_bound( j, b.index.end(), a.index[i] );
+			if( j == b.index.end()) break;
+			if( *j != a.index[i] ) continue;
+
+			const uint64_t w = a.bits[i] & b.bits[ j - b.index.begin()];
+			if( w ) push( a.index[i], w );
+		}
+	};
+
+	inline void swap( SequenceBitmap& b ) {
+		index.swap( b.index );
+		bits.swap( b.bits );
+		std::swap( n, b.n );
+	};
+};
+
+/**
+ * Dense bitmap of a set of Sequences in [0,universe), with the cardinality cached
+ * 
+ * Unions and intersection tests with SequenceBitmaps are word-wide
+ */
+class SequenceSet {
+private:
+	vector<uint64_t> bits;
+	size_t n = 0;
+
+public:
+	SequenceSet( Sequence universe ) : bits(( size_t( universe ) + 63 ) / 64, 0 ) {};
+
+	inline size_t size() const { return n; };
+	inline bool empty() const { return !n; };
+
+	/**
+	 * Add the Sequences of \param b
+	 */
+	inline SequenceSet& operator+= ( const SequenceBitmap& b ) {
+		for( size_t i = 0 ; i < b.index.size() ; i++ ) {
+			uint64_t& w = bits.at( b.index[i] );
+			n += __builtin_popcountll( b.bits[i] & ~w );
+			w |= b.bits[i];
+		}
+		return *this;
+	};
+
+	/**
+	 * Whether any Sequence of \param b is in the set
+	 */
+	inline bool intersects( const SequenceBitmap& b ) const {
+		for( size_t i = 0 ; i < b.index.size() ; i++ ) {
+			if( bits.at( b.index[i] ) & b.bits[i] ) return true;
+		}
+		return false;
+	};
+
+	/**
+	 * Call \param f( se ) for all Sequences se of the set, in increasing order
+	 */
+	template<class F> inline void forEach( F f ) const {
+		for( size_t i = 0 ; i < bits.size() ; i++ ) {
+			for( uint64_t w = bits[i] ; w ; w &= w-1 ) {
+				f( Sequence( 64*i + __builtin_ctzll( w )));
+			}
+		}
+	};
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -11,6 +11,8 @@
 #include <unordered_map>
 
 #include <atomic>
+#include <memory>
+#include <mutex>
 
 #include "Tree.h"
 
@@ -23,8 +25,10 @@
 #include "Fold.h"
 
 #include "ParserFasta.h"
+#include "PackedSequence.h"
 
 #include "util.h"
+#include "Memory.h"
 
 using namespace std;
 
@@ -38,9 +42,24 @@ extern void tax_restart( FILE* );
 /**
  * Source database of sequences
  */
-class Source : public ParserFasta
+class Source
 {
 	friend class Reference;
+	friend class TrieIndex;
+	friend class SourceDatabase;
+public:
+	/**
+	 * Conditions of the melting temperature filter (\see filterMelting)
+	 */
+	struct Melting {
+		double max_melting;
+		double strand_concentration;
+		double salt_concentration;
+
+		inline bool operator== ( const Melting& m ) const {
+			return ( max_melting == m.max_melting ) && ( strand_concentration == m.strand_concentration ) && ( salt_concentration == m.salt_concentration );
+		};
+	};
 private:
 	Length minim;
 	Length maxim;
@@ -50,6 +69,114 @@ private:
 	Length max_homolo;
 
 	ostream& fold_output;
+
+	const bool b_reverse_complement; // whether to add the reverse complement of each fragment (\see ParserFasta)
+
+	/**
+	 * Content of all fragments (4-bit nucleotides), packed (\see PackedSequence)
+	 */
+	PackedSequence content;
+
+	Sequence next_sequence = 0;     // id of the next new sequence
+	TypeFragment next_fragment = 0; // id of the next fragment
+
+	bool b_melted = false; // whether max_length_at is filtered for melting temperatures, in the conditions of melting
+	Melting melting = {};
+
+	/**
+	 * Extend the array of "melting lengths" \param mla with the lengths for the fragment with cover \param amb
+	 * 
+	 * NOTE: the lengths only depend on the positions relative to the fragment
+	 */
+	static void extendLengths( deque<Length>& mla, const Cover<Position>& amb, Length minim, Length maxim ) {
+		mla.resize( mla.size() + amb.range().size(), 0 ); // extend the array of lengths; default = 0
+
+		for( const Range<Position>& r: -amb ) { // initialize array of lengths with "cover" values
+			for( Position p = r.lo() ; ; p++ ) {
+				const Length le = r.cover( p, minim, maxim );
+				if( !le ) break;
+
+				mla.at( p ) = le;
+			}
+		}
+	};
+
+	/**
+	 * Record a fragment (the content and the lengths are already there): filter it,
+	 * then assign the ids of its sequence and of the fragment
+	 */
+	void addFragment( const string& na, const string& fn, const Cover<Position>& amb, const bool rc ) {
+		if( filterAmbiguous( na, fn, amb )) {
+			return;
+		}
+
+		if( filterAmbiguousCrowded( na, fn, amb )) {
+			return;
+		}
+
+		Sequence se = next_sequence;
+
+		int r = instances.emplace( na, next_sequence );
+		if( !r ) {
+			targets.emplace( { next_sequence }, na ); // add sequence to list of targets
+			++next_sequence;
+		}
+
+		switch( r ) {
+			case 0:
+				instance_fragments.emplace( se, next_fragment );
+				fragment_position.emplace( next_fragment, amb.range().hi());
+				fragments.emplace( next_fragment++, Fragment{ fn, amb, maxim, rc });
+				break;
+			case 1:
+				instance_fragments.emplace( instances.at( na ), next_fragment );
+				fragment_position.emplace( next_fragment, amb.range().hi());
+				fragments.emplace( next_fragment++, Fragment{ fn, amb, maxim, rc });
+				break;
+			case 2:
+			default:
+				error( "A sequence with this id already exists: ", na, "/", next_sequence );
+		}
+	};
+
+	/**
+	 * One sequence file, parsed on its own (\see parseFiles)
+	 * 
+	 * Keeps the (unpacked) content, the lengths and the fragments of the file; positions start at 0
+	 */
+	class FileStage : public ParserFasta {
+	public:
+		struct StagedFragment {
+			string name;
+			string file_name;
+			Cover<Position> amb;
+			bool rc;
+		};
+
+		deque<Length> max_length_at;
+		vector<StagedFragment> staged;
+
+		FileStage( Length m, Length M, const bool rc ): ParserFasta( rc ), minim( m ), maxim( M ) {};
+
+		virtual void onReserve( size_t n ) {
+			content.reserve( n );
+		};
+
+		virtual void onFragment( const string& na, const string& fn, const Cover<Position>& amb, const bool rc = false ) {
+			extendLengths( max_length_at, amb, minim, maxim );
+			staged.push_back( StagedFragment{ na, fn, amb, rc });
+		};
+
+		inline const string& getContent() const { return content; };
+	private:
+		const Length minim;
+		const Length maxim;
+	};
+
+	/**
+	 * Append the content (packed), the lengths and the fragments of \param st to the Source
+	 */
+	void merge( FileStage& st );
 public:
 	One2One<string,Sequence> instances;
 	One2Many<Sequence,TypeFragment> instance_fragments;
@@ -83,63 +210,23 @@ public:
 	deque<Length> max_length_at;
 
 	Source( Length m, Length M, Position ma, Position mca, Length mh, ostream& fo = onull, const bool rc = false ) :
-		ParserFasta( rc ),
 		minim( m ),
 		maxim( M ),
 		max_ambiguities( ma ),
 		max_crowded_ambiguities( mca ),
 		max_homolo( mh ),
 		fold_output( fo ),
+		b_reverse_complement( rc ),
 		has_tree( false )
 		{};
 
-	virtual void onFragment( const string& na, const string& fn, const Cover<Position>& amb, const bool rc = false ) {
-		static Sequence seq = 0; // sequence id
-		static TypeFragment fra = 0; // fragment id
-
-		max_length_at.resize( max_length_at.size() + amb.range().size(), 0 ); // extend the array of lengths; default = 0
-
-		for( const Range<Position>& r: -amb ) { // initialize array of lengths with "cover" values
-			for( Position p = r.lo() ; ; p++ ) {
-				const Length le = r.cover( p, minim, maxim );
-				if( !le ) break;
-
-				max_length_at.at( p ) = le;
-			}
-		}
-
-		if( filterAmbiguous( na, fn, amb )) {
-			return;
-		}
-
-		if( filterAmbiguousCrowded( na, fn, amb )) {
-			return;
-		}
-
-		Sequence se = seq;
-
-		int r = instances.emplace( na, seq );
-		if( !r ) {
-			targets.emplace( { seq }, na ); // add sequence to list of targets
-			++seq;
-		}
-
-		switch( r ) {
-			case 0:
-				instance_fragments.emplace( se, fra );
-				fragment_position.emplace( fra, amb.range().hi());
-				fragments.emplace( fra++, Fragment{ fn, amb, maxim, rc });
-				break;
-			case 1:
-				instance_fragments.emplace( instances.at( na ), fra );
-				fragment_position.emplace( fra, amb.range().hi());
-				fragments.emplace( fra++, Fragment{ fn, amb, maxim, rc });
-				break;
-			case 2:
-			default:
-				error( "A sequence with this id already exists: ", na, "/", seq );
-		}
-	};
+	/**
+	 * Read the sequence files \param files, in parallel on \param threads threads
+	 * 
+	 * Each file is parsed on its own (\see FileStage), then packed and merged into the Source in the order of
+	 * \param files: content, sequence ids and fragment ids are the same as when reading the files one by one
+	 */
+	void parseFiles( const vector<string>& files, unsigned int threads );
 
 	/**
 	 * Write names of excluded fragments to a file
@@ -321,16 +408,25 @@ public:
 	void readIsolationList( const string& isolation_file_name );
 
 	void filterMelting( const unsigned int threads, const double max_melting, const double strand_concentration, const double salt_concentration );
-	void _filterMelting( bool& first, const double& max_melting, const double& strand_concentration, const double& salt_concentration );
 
-	inline const string& getSource() const { return content; };
+	/**
+	 * \returns whether max_length_at is already filtered for melting temperatures (e.g. restored from a
+	 * SourceDatabase); \param m the conditions of the filter
+	 */
+	inline bool isMelted( Melting& m ) const {
+		m = melting;
+		return b_melted;
+	};
+	void _filterMelting( const Fragment& fr, const Thermo& th, const string& head );
+
+	inline const PackedSequence& getSource() const { return content; };
 	inline deque<Length>& getMaxLengthAt() { return max_length_at; };
 	inline const string& getSequenceName( Sequence i ) const { return instances.at( i ); };
 
 	inline const map<set<Sequence>,string>& getTargets() { return targets.from; };
 
 	inline string printableSubsequence( Position p, Position l ) const {
-		return convertNu2Asc( content.substr( p, l ));
+		return convertNu2Asc( content.unpack( p, l ));
 	};
 	inline string printableSubsequence( const Range<Position>& r ) const {
 		return printableSubsequence( r.lo(), r.hi()-r.lo());
@@ -343,6 +439,21 @@ public:
 		return content.at( p );
 	};
 
+	/**
+	 * \returns number of leading positions with the same symbols in the \param l symbols at \param p1 and at \param p2
+	 */
+	inline Position common( Position p1, Position p2, Position l ) const {
+		return content.common( p1, p2, l );
+	};
+
+	/**
+	 * \returns number of leading positions with matching (possibly ambiguous) symbols in the \param l symbols
+	 * at \param p1 and at \param p2
+	 */
+	inline Position overlapping( Position p1, Position p2, Position l ) const {
+		return content.overlapping( p1, p2, l );
+	};
+
 	inline Position length() const {
 		return content.size();
 	};
@@ -362,6 +473,15 @@ public:
 			&& cluster_species.at( cl ).count( species_reference.at( reference.at( re )));
 	};
 
+	/**
+	 * Add the storage (bytes) of the main structures of the Source to \param m
+	 */
+	inline void memory( MemoryBreakdown& m ) const {
+		m["source content"] += footprint( content );
+		m["source max_length_at"] += footprint( max_length_at );
+		m["source clusters"] += footprint( clusters.from ) + footprint( clusters.to );
+	};
+
 // 	TEST
 	void show( ostream& out ) const;
 	void showSequence( ostream& out, Sequence s ) const;
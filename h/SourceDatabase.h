@@ -0,0 +1,69 @@
+#ifndef __SourceDatabase_h__
+#define __SourceDatabase_h__
+
+#include <iostream>
+#include <string>
+
+#include <cstdint>
+
+using namespace std;
+
+#include "Types.h"
+#include "Error.h"
+
+class Source;
+
+/**
+ * On-disk sequence database: the encoded state of a Source after reading the sequence files and,
+ * if requested, after filtering for melting temperatures ("compile once, run many")
+ * 
+ * Reading the database replaces the parsing of the sequence files, the construction of the ambiguity
+ * Covers, the initialization of max_length_at and the melting temperature filter. The phylogeny tree,
+ * the outgroup and the isolation list are not part of the database: they can change from run to run
+ * 
+ * File layout (native byte order, 8-byte aligned sections; \see IndexWriter):
+ *  - header: magic, version, byte order mark, parameters of the Source (oligo sizes, ambiguity filters,
+ *    reverse complement) and conditions of the melting temperature filter
+ *  - Source content, packed (\see PackedSequence)
+ *  - max_length_at
+ *  - sequence names, fragments and names of the excluded fragments
+ * 
+ * WARNING: database files are not portable between architectures with different byte orders
+ */
+class SourceDatabase {
+public:
+	static const uint64_t version = 1;
+
+	/**
+	 * Write the state of \param src to \param out
+	 */
+	static void write( ostream& out, const Source& src );
+
+	/**
+	 * Fill (empty) Source \param src with the database file at \param path (mapped with mmap)
+	 * 
+	 * The parameters of \param src (oligo sizes, ambiguity filters, reverse complement) must be the
+	 * ones the database was written with
+	 */
+	static void read( const string& path, Source& src );
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -0,0 +1,193 @@
+#ifndef __ThreadPool_h__
+#define __ThreadPool_h__
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <algorithm>
+#include <exception>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+/**
+ * Persistent pool of worker threads, shared by all multi-threaded phases of the process
+ * 
+ * Threads are started when first needed and kept (waiting) until the end of the process.
+ * All the state of an invocation is local to the invocation: the same phase can run more
+ * than once, or concurrently from different threads
+ * 
+ * \see parallel, parallelFor
+ */
+class ThreadPool {
+public:
+	/**
+	 * The pool shared by the whole process
+	 */
+	static ThreadPool& instance();
+
+	/**
+	 * Execute \param task once for each worker index in [0,\param t) and wait for all to finish
+	 * 
+	 * The calling thread executes worker 0. The first exception thrown by any worker is re-thrown
+	 * in the calling thread, after all workers have finished
+	 * 
+	 * NOTE: invocations from inside a task are executed sequentially by the calling thread
+	 * 
+	 * NOTE: after worker 0, the calling thread takes back the workers of the invocation that no thread of
+	 *       the pool has started and executes them itself: an invocation finishes even when all the threads
+	 *       of the pool are busy, e.g. with tasks waiting for the calling thread
+	 */
+	void run( unsigned int t, const function<void( unsigned int )>& task );
+
+	~ThreadPool();
+
+private:
+	ThreadPool(): stopping( false ) {};
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator= ( const ThreadPool& ) = delete;
+
+	void work();
+
+	/**
+	 * Worker of an invocation, waiting to be picked up by a thread of the pool
+	 */
+	struct Task {
+		const void* invocation; // state of the invocation (\see run)
+		function<void()> f;
+	};
+
+	vector<thread> workers;
+	deque<Task> tasks; // waiting to be picked up by a worker
+
+	mutex lock; // protects workers, tasks and stopping
+	condition_variable wake;
+	bool stopping;
+
+	static thread_local bool inside; // the current thread is executing a task of the pool
+};
+
+/**
+ * Execute \param f( w ) on \param t threads of the pool (worker index w in [0,t))
+ * and wait for all of them to finish
+ * 
+ * Each worker is responsible with sharing the workload with the others (\see parallelFor)
+ */
+template<class F> inline void parallel( unsigned int t, F f ) {
+	ThreadPool::instance().run( t, f );
+}
+
+/**
+ * Execute \param f( i ) for all i in [0,\param n) on \param t threads of the pool
+ * and wait for all of them to finish
+ * 
+ * NOTE: indexes are handed out one at a time, in increasing order, to the first idle thread
+ */
+template<class F> inline void parallelFor( unsigned int t, size_t n, F f ) {
+	atomic<size_t> next( 0 ); // shared by the workers of this invocation only
+
+	parallel( unsigned( min( size_t( t ), n )), [&]( unsigned int ) {
+		for( size_t i ; ( i = next++ ) < n ; ) {
+			f( i );
+		}
+	});
+}
+
+/**
+ * Execute \param f( lo, hi ) for disjoint sub-ranges [lo,hi) covering [0,\param n) on \param t threads
+ * of the pool (work stealing) and wait for all of them to finish
+ * 
+ * Each thread starts with an equal, contiguous share of [0,n) and takes chunks from its front:
+ * half of what is left in its share, but at most \param grain indexes. An idle thread steals the
+ * back half of the largest share left, which becomes its own share
+ * 
+ * NOTE: locks are only taken once per chunk, never per index
+ */
+template<class F> inline void parallelRanges( unsigned int t, size_t n, size_t grain, F f ) {
+	t = unsigned( min( size_t( t ), n ));
+	grain = max( grain, size_t( 1 ));
+
+	struct Share { // indexes [lo,hi) left to a thread
+		mutex lock;
+		size_t lo;
+		size_t hi;
+	};
+
+	vector<Share> shares( t ); // state of this invocation only
+	for( unsigned int w = 0 ; w < t ; w++ ) {
+		shares.at( w ).lo = n * w / t;
+		shares.at( w ).hi = n * ( w+1 ) / t;
+	}
+
+	parallel( t, [&]( unsigned int w ) {
+		Share& own = shares.at( w );
+
+		while( true ) {
+			own.lock.lock();
+			const size_t lo = own.lo;
+			const size_t hi = min( own.hi, lo + min( grain, max(( own.hi - lo + 1 ) / 2, size_t( 1 ))));
+			own.lo = hi;
+			own.lock.unlock();
+
+			if( lo < hi ) {
+				f( lo, hi );
+				continue;
+			}
+
+// 	own share exhausted: steal from the largest share left
+			size_t slo = 0, shi = 0;
+
+			while( true ) {
+				Share* victim = nullptr;
+				size_t left = 0;
+
+				for( Share& sh: shares ) { // approximate; checked again under the victim's lock
+					lock_guard<mutex> g( sh.lock );
+					if( sh.hi - sh.lo > left ) {
+						left = sh.hi - sh.lo;
+						victim = &sh;
+					}
+				}
+
+				if( !victim ) return; // nothing left anywhere; chunks in progress finish on their own
+
+				lock_guard<mutex> g( victim->lock );
+				if( victim->lo >= victim->hi ) continue; // taken in the meantime; look again
+
+				slo = victim->lo + ( victim->hi - victim->lo ) / 2;
+				shi = victim->hi;
+				victim->hi = slo;
+				break;
+			}
+
+			own.lock.lock();
+			own.lo = slo;
+			own.hi = shi;
+			own.lock.unlock();
+		}
+	});
+}
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
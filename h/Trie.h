@@ -24,6 +24,7 @@
 
 #include "Cover.h"
 #include "Source.h"
+#include "ClusterTable.h"
 
 #include "Types.h"
 
@@ -41,16 +42,19 @@ template<typename T> ostream& operator<< ( ostream& o, const vector<T>& v ) {
 
 class Trie
 {
+	friend class TrieIndex;
 //=============================================================================================
 // 	CONSTANTS
 //=============================================================================================
 public:
 	/**
-	 * Depth to which the Trie is a lookup table of TrieSlices
+	 * Limits and default for the depth to which the Trie is a lookup table of TrieSlices
 	 * 
-	 * WARNING: must be 4, since Prefix4 is hardcoded
+	 * WARNING: the maximum depth is limited by the size of Prefix (4 bits per base)
 	 */
-	static const Depth fixed_depth  = 4;
+	static const Depth min_depth     = 4;
+	static const Depth max_depth     = 8;
+	static const Depth default_depth = 4;
 
 //=============================================================================================
 // 	DATA members
@@ -60,6 +64,11 @@ public:
 	const Length minim;  // minimum length of a signature oligo
 	const Length maxim;  // maximum length of a signature oligo
 
+	/**
+	 * Depth to which the Trie is a lookup table of TrieSlices (length of the prefixes)
+	 */
+	const Depth fixed_depth;
+
 	/**
 	 * All collected "group" oligonucleotides
 	 * 
@@ -72,20 +81,35 @@ public:
 	 * 
 	 */
 	map<Cluster,vector<PositionDepthLength>> matches;
+	mutex matches_lock; // protects matches while collecting them from multiple threads
+
+	/**
+	 * Add an occurrence of cluster \param c to the matches or, while all the matches are collected at
+	 * once, to its place (\see Trie::collectMatches)
+	 * 
+	 * WARNING: must be called under matches_lock
+	 */
+	inline void addMatch( Cluster c, PositionDepthLength pdl ) {
+		if( match_next.empty()) matches[c].push_back( pdl );
+		else *( match_next.at( c )++ ) = pdl;
+	};
+
+private:
+	vector<PositionDepthLength*> match_next; // place of the next occurrence of each cluster, while collecting all at once
 
 protected:
 	/**
 	 * Convert from an encoded prefix to a "cake" sequential index
 	 */
-	unordered_map<Prefix4,Slice> prefixes;
+	unordered_map<Prefix,Slice> prefixes;
 	/**
 	 * List of "cake" indexes that match a prefix (including ambiguous)
 	 */
-	unordered_multimap<Prefix4,Slice> prefix_match;
+	unordered_multimap<Prefix,Slice> prefix_match;
 	/**
 	 * List of "cake" indexes that match a prefix with exactly one difference
 	 */
-	unordered_multimap<Prefix4,Slice> prefix_diff1;
+	unordered_multimap<Prefix,Slice> prefix_diff1;
 
 	/**
 	 * Lookup table of TrieSlice-s
@@ -94,6 +118,43 @@ protected:
 	 */
 	deque<TrieSlice> cake;
 
+	/**
+	 * Clusters of all slices, while encoding them (\see encodeClusters)
+	 */
+	ClusterTable cluster_table;
+
+	/**
+	 * Subsequence to add to a TrieSlice
+	 */
+	struct BucketElement {
+		Position p;
+		Sequence s;
+		Length   l;
+	};
+
+	/**
+	 * All subsequences to add to the Trie, bucketed by slice (counting sort); temporary, filled and used by cover
+	 * 
+	 * NOTE: within a slice, subsequences are in the same order as in a sequential traversal of the Source
+	 */
+	vector<BucketElement> bucket_elements;
+	/**
+	 * Chunks of fragments (start of each chunk) bucketed independently
+	 */
+	vector<decltype( source.instance_fragments.from )::const_iterator> bucket_chunks;
+	/**
+	 * Counts, then write offsets into bucket_elements, for each chunk and slice: [chunk*slices + slice]
+	 */
+	vector<size_t> bucket_offsets;
+	/**
+	 * Start of each slice in bucket_elements
+	 */
+	vector<size_t> bucket_slices;
+	/**
+	 * true while counting elements; false while writing them into their buckets
+	 */
+	bool bucket_counting;
+
 //=============================================================================================
 // 	FUNCTIONALS; needed for using the same Trie::loop function for iterating over the Trie
 //=============================================================================================
@@ -134,12 +195,6 @@ protected:
 	};
 
 // 	WARNING: some loops use Cover::cover, some Range::cover
-	const struct : ElementFunction {
-		virtual void operator() ( Trie& t, Position po, Length le, Sequence se ) const {
-			t.add( po, le, se );
-		};
-	} elementAdd;
-	
 	const struct : ElementFunction {
 		virtual void operator() ( Trie& t, Position po, Length le, Sequence se ) const {
 			t.mark( po, le, se );
@@ -184,7 +239,7 @@ protected:
 // 	CODE
 //=============================================================================================
 public:
-	Trie( Source& so, Length m, Length M );
+	Trie( Source& so, Length m, Length M, Depth depth = default_depth );
 
 	void cover( unsigned int threads );
 	void touch( unsigned int threads );
@@ -192,11 +247,18 @@ public:
 	void smallDiff( unsigned int threads );
 	void confirm( unsigned int threads, const string& s, const vector<pair<string,Range<Position>>>& );
 
-	void encodeClusters();
-	void collectClusters( unsigned int threads );
+	void encodeClusters( unsigned int threads );
 	void collectMatches( unsigned int threads );
+	void collectMatches( unsigned int threads, const vector<size_t>& counts, vector<PositionDepthLength>& ma, vector<size_t>& offsets );
 	void sortMatches( unsigned int threads );
 
+	/**
+	 * \returns the number of matches of each cluster, indexed by cluster id (\see collectMatches)
+	 * 
+	 * WARNING: must be called AFTER encodeClusters
+	 */
+	vector<size_t> countMatches( unsigned int threads );
+
 	/**
 	 * Build the array of TrieSlice based on prefixes encountered in the source
 	 * Create the multimaps:
@@ -213,7 +275,7 @@ public:
 	/**
 	 * \returns the cluster id associated with a site in the Source (EXPERIMENTAL)
 	 * 
-	 * WARNING: must be called AFTER collectClusters
+	 * WARNING: must be called AFTER encodeClusters
 	 */
 	const Cluster getClusterId( Position p, Length l );
 
@@ -228,7 +290,7 @@ public:
 	 * 
 	 * \returns false if no cluster was found
 	 */
-	const bool getCluster( const string& s, Position p, Length l, Cluster& clu );
+	virtual const bool getCluster( const string& s, Position p, Length l, Cluster& clu );
 
 // 	/**
 // 	 * Finds subsequence without ambiguities in Trie
@@ -246,18 +308,22 @@ public:
 		Distribution& nucleo_distribution, Distribution& prefix_distribution, Distribution& depth_distribution, Distribution& length_distribution, Distribution& occurrence_distribution, Distribution& cluster_distribution
 	) const;
 
+	/**
+	 * Add the storage (bytes) of the main structures of the Trie and of its Source to \param m
+	 */
+	void memory( MemoryBreakdown& m ) const;
+
 protected:
-	virtual void _cover( bool& );
-	virtual void _touch( bool& );
-	virtual void _filterHomolo( bool&, const Length& max_homolo );
-	virtual void _smallDiff( bool& );
-	virtual void _confirm( bool&, const string&, const vector<pair<string,Range<Position>>>& );
+	virtual void _bucket( size_t chunk );
+	virtual void _cover( Slice sl );
+	virtual void _touch( unsigned int threads );
+	virtual void _filterHomolo( Prefix pr, Slice sl, Length max_homolo );
 	virtual void __confirm( const string&, Sequence re, Position p, Length l );
-	virtual void _collectClusters( bool& );
-	virtual void _collectMatches( bool& );
-	virtual void _sortMatches( bool& );
+	virtual void _encodeClusters( Slice sl );
+	virtual void _collectClusters( Slice sl );
+	virtual void _collectMatches( Slice sl );
+	virtual void _countMatches( Slice sl, vector<size_t>& counts );
 
-	void add( Position p, Length l, Sequence s );
 	virtual void mark( Position p, Length l, Sequence s );
 	virtual void diff( Position p, Length l, Sequence s );
 
@@ -267,28 +333,28 @@ protected:
 	 * Get the trie slice associated with the prefix found at \param p
 	 */
 	inline TrieSlice& getSlice( Position p ) {
-		return getSlice( source.getSource(), p );
+		return cake.at( prefixes.at( nu2pr( source.getSource(), p, fixed_depth )));
 	}
 
 	/**
 	 * Get the trie slice associated with the prefix found in string \param s at \param p
 	 */
 	inline TrieSlice& getSlice( const string& s, Position p ) {
-		return cake.at( prefixes.at( nu2p4( s, p )));
+		return cake.at( prefixes.at( nu2pr( s, p, fixed_depth )));
 	}
 
 	/**
 	 * Pair of iterators describing all slices that match the prefix at position \param p in the source
 	 */
-	pair<unordered_multimap<Prefix4,Slice>::const_iterator,unordered_multimap<Prefix4,Slice>::const_iterator> getSlicesMatching( Position p ) const {
-		return prefix_match.equal_range( nu2p4( source.getSource(), p ));
+	pair<unordered_multimap<Prefix,Slice>::const_iterator,unordered_multimap<Prefix,Slice>::const_iterator> getSlicesMatching( Position p ) const {
+		return prefix_match.equal_range( nu2pr( source.getSource(), p, fixed_depth ));
 	};
 
 	/**
 	 * Pair of iterators describing all slices that have exactly one difference compared to the prefix at position \param p in the source
 	 */
-	pair<unordered_multimap<Prefix4,Slice>::const_iterator,unordered_multimap<Prefix4,Slice>::const_iterator> getSlicesDiff1( Position p ) const {
-		return prefix_diff1.equal_range( nu2p4( source.getSource(), p ));
+	pair<unordered_multimap<Prefix,Slice>::const_iterator,unordered_multimap<Prefix,Slice>::const_iterator> getSlicesDiff1( Position p ) const {
+		return prefix_diff1.equal_range( nu2pr( source.getSource(), p, fixed_depth ));
 	};
 
 	/**
@@ -298,13 +364,35 @@ protected:
 	void newSlice( Position p );
 
 	/**
-	 * Generic multithread-safe loop thay will execute an ElementFunction (functional)
+	 * Create TrieSlice-s for all the prefixes that do not have one yet
+	 */
+	void newSlices();
+
+	/**
+	 * \returns all unambiguous prefixes that match the (possibly ambiguous) prefix \param pr
+	 * in all but exactly \param diff positions
+	 */
+	vector<Prefix> matchingPrefixes( Prefix pr, Length diff ) const;
+
+	/**
+	 * Generic multi-threaded loop that will execute an ElementFunction (functional)
 	 * for every subsequence of a Cover returned by a CoverFunction (functional)
 	 * of length returned by a LengthFunction (functional)
 	 * 
-	 * NOTE: the same loop is used by add, mark and diff for Trie and TrieAmbig
+	 * Positions are handed out to \param threads threads in chunks, with work stealing (\see parallelRanges)
+	 * 
+	 * NOTE: the same loop is used by mark and diff for Trie and TrieAmbig
+	 */
+	void loop( unsigned int threads, const CoverFunction& cov, const LengthFunction& len, const ElementFunction& ele );
+
+	/**
+	 * Generic loop that buckets, by slice, every subsequence of a Cover returned by a CoverFunction
+	 * (functional) of length returned by a LengthFunction (functional) for one chunk of fragments \param ch
+	 * 
+	 * Each thread processes whole chunks of fragments; called twice: once for counting and
+	 * once for writing the subsequences in their buckets (\see Trie::bucket_counting)
 	 */
-	void loop( bool& first, const CoverFunction& cov, const LengthFunction& len, const ElementFunction& ele );
+	void bucket( size_t ch, const CoverFunction& cov, const LengthFunction& len );
 
 //=============================================================================================
 // 	TEST
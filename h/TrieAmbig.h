@@ -8,14 +8,14 @@ using namespace std;
 class TrieAmbig: public Trie {
 private:
 public:
-	TrieAmbig( Source& so, Length m, Length M ): Trie( so, m, M ) {};
+	TrieAmbig( Source& so, Length m, Length M, Depth depth = default_depth ): Trie( so, m, M, depth ) {};
 protected:
-	virtual void _cover( bool& first ){
-		loop( first, range, lengthRange, elementAdd );
+	virtual void _bucket( size_t ch ){
+		bucket( ch, range, lengthRange );
 	};
 
-	virtual void _touch( bool& first ){
-		loop( first, range, lengthRange, elementMark );
+	virtual void _touch( unsigned int threads ){
+		loop( threads, range, lengthRange, elementMark );
 	}
 
 	virtual void buildSlices() {
@@ -30,14 +30,14 @@ protected:
 			}
 		}
 
-		cake.resize( prefixes.size());
+		newSlices();
 
 // 	populate the ambig prefix match
 		for( const auto& e2pr1: prefixes ) { // cross-match all prefixes
 			prefix_match.emplace( e2pr1.first, e2pr1.second ); // match a prefix with its own slice
 
 			for( const auto& e2pr2: prefixes ) { // unambiguous prefixes match only themselves
-				if( p4ma( e2pr1.first, e2pr2.first ) == 4 ) {
+				if( prma( e2pr1.first, e2pr2.first, fixed_depth ) == fixed_depth ) {
 					prefix_match.emplace( e2pr1.first, e2pr2.second );
 				}
 			}
@@ -46,7 +46,7 @@ protected:
 // 	populate the diff1 prefix match
 		for( const auto& e2pr1: prefixes ) {
 			for( const auto& e2pr2: prefixes ) { // add all diff1 unambiguous prefixes
-				if( p4ma( e2pr1.first, e2pr2.first ) == 3 ) {
+				if( prma( e2pr1.first, e2pr2.first, fixed_depth ) == fixed_depth-1 ) {
 					prefix_diff1.emplace( e2pr1.first, e2pr2.second );
 				}
 			}
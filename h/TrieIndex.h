@@ -0,0 +1,124 @@
+#ifndef __TrieIndex_h__
+#define __TrieIndex_h__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+
+#include <cstdint>
+
+using namespace std;
+
+#include "Types.h"
+#include "Error.h"
+#include "IndexFile.h"
+#include "PackedSequence.h"
+
+class Source;
+class Trie;
+
+/**
+ * On-disk index of a fully built (and filtered) Trie: the nodes of all slices, the cluster
+ * of each node, the Source content and the metadata of its sequences and fragments
+ * 
+ * The index file is mapped read-only into memory (mmap); the nodes are looked up directly in the
+ * mapping, no Trie is rebuilt; the packed content (2 bits per unambiguous nucleotide) is copied. Only
+ * the Source metadata needed by Match (names, fragments, clusters) is restored into a Source
+ * 
+ * File layout (native byte order, 8-byte aligned sections):
+ *  - header: magic, version, byte order mark, prefix depth, oligo sizes, number of slices
+ *  - Source content: the packed arrays (\see PackedSequence)
+ *  - for each slice: node sources, children, children masks and cluster ids (arrays of TrieNodes)
+ *  - Source metadata: sequence names, fragments, clusters (in cluster id order)
+ * 
+ * NOTE: only unambiguous Tries are supported (no --ambiguous-oligos)
+ * WARNING: index files are not portable between architectures with different byte orders
+ */
+class TrieIndex {
+public:
+	static const uint64_t version = 2;
+
+	/**
+	 * Write the index of \param trie to \param out
+	 */
+	static void write( ostream& out, const Trie& trie );
+
+	/**
+	 * Map the index file at \param path
+	 */
+	TrieIndex( const string& path );
+
+	TrieIndex( const TrieIndex& ) = delete;
+	TrieIndex& operator= ( const TrieIndex& ) = delete;
+
+	inline Depth getDepth() const { return fixed_depth; };
+	inline Length getMinim() const { return minim; };
+	inline Length getMaxim() const { return maxim; };
+
+	/**
+	 * Fill (empty) Source \param src with the content, sequences, fragments and clusters of the index
+	 */
+	void restore( Source& src ) const;
+
+	/**
+	 * Get the cluster id associated with a substring (\see Trie::getCluster)
+	 * 
+	 * \param s source string
+	 * \param p start position
+	 * \param l length of substring
+	 * 
+	 * \param clu cluster id (output)
+	 * 
+	 * \returns false if no cluster was found
+	 */
+	bool getCluster( const string& s, Position p, Length l, Cluster& clu ) const;
+
+private:
+	/**
+	 * Nodes of a TrieSlice, in the mapping
+	 */
+	struct SliceNodes {
+		Node nodes;
+		const PositionLength*   source;
+		const array<Node,4>*    children_table;
+		const unsigned short*   children_mask;
+		const Cluster*          cluster;
+	};
+
+	const string path;
+
+	const IndexMapping mapping;
+	const char* const data; // mapping of the whole file
+	const size_t size;
+
+	Depth  fixed_depth;
+	Length minim;
+	Length maxim;
+
+	vector<SliceNodes> slices;
+
+	PackedSequence content; // Source content (\see Source::content)
+
+	size_t source_offset; // start of the Source metadata (sequence names)
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
@@ -0,0 +1,48 @@
+#ifndef __TrieMapped_h__
+#define __TrieMapped_h__
+
+#include "Trie.h"
+#include "TrieIndex.h"
+
+using namespace std;
+
+/**
+ * Trie read from an index file (--index) instead of being built from sequence files
+ * 
+ * The Source is restored from the index; subsequences are looked up directly in the mapped
+ * index, which replaces the "cake". Only lookups (getCluster, \see Match) are supported
+ */
+class TrieMapped: public Trie {
+protected:
+	const TrieIndex& index;
+
+public:
+	TrieMapped( Source& so, const TrieIndex& ix ):
+		Trie( so, ix.getMinim(), ix.getMaxim(), ix.getDepth()), index( ix ) {
+		index.restore( source );
+	};
+
+	virtual const bool getCluster( const string& s, Position p, Length l, Cluster& clu ) {
+		return index.getCluster( s, p, l, clu );
+	};
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
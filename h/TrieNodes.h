@@ -0,0 +1,207 @@
+#ifndef __TrieNodes_h__
+#define __TrieNodes_h__
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+#include "Types.h"
+#include "Memory.h"
+
+/**
+ * Children of a node, in symbol order
+ * 
+ * Small, fixed-capacity container; one entry per 4-bit symbol at most
+ */
+class TrieChildren {
+private:
+	array<SymbolNode,15> c;
+	unsigned char n;
+
+public:
+	TrieChildren(): n( 0 ) {};
+
+	inline void push_back( SymbolNode sn ) { c[n++] = sn; };
+
+	inline const SymbolNode* begin() const { return c.data(); };
+	inline const SymbolNode* end() const { return c.data()+n; };
+
+	inline size_t size() const { return n; };
+	inline bool empty() const { return !n; };
+};
+
+/**
+ * Node store of a TrieSlice
+ * 
+ * All node attributes are kept in contiguous arrays indexed by Node (struct-of-arrays):
+ * - the source (position and length) of each node
+ * - the children of each node, indexed directly by the 2-bit prefix code of their unambiguous symbol
+ * - a bitmap of the 4-bit symbols of the children of each node
+ * - the cluster id of each node (Cluster_invalid if none)
+ * 
+ * Children with ambiguous symbols (only with --ambiguous-oligos) are kept separately, in a hash.
+ * 
+ * NOTE: node 0 is the root of the slice; since it is never a child, 0 marks an empty child slot
+ * NOTE: erasing children only erases the navigation elements; the payload remains, but is inaccessible
+ */
+class TrieNodes {
+	friend class TrieIndex;
+//=======================================
+// 	DATA
+//=======================================
+private:
+	vector<PositionLength> source;
+	vector<array<Node,4>>  children_table; // unambiguous children, indexed by nu2pre
+	vector<unsigned short> children_mask;  // bit sy is set for each child with symbol sy
+
+	unordered_map<SymbolNode,Node> children_ambig; // children with ambiguous symbols
+
+	vector<Cluster> cluster; // id of the cluster of sequences that correspond to the node
+
+	Node edges; // number of accessible children
+
+//=======================================
+// 	CODE
+//=======================================
+public:
+	TrieNodes(): edges( 0 ) {
+		newNode( positionLength( 0, 0 ));
+	};
+
+	/**
+	 * \returns number of allocated nodes (including the inaccessible ones)
+	 */
+	inline Node nodes() const { return source.size(); };
+
+	/**
+	 * \returns number of accessible children
+	 */
+	inline Node size() const { return edges; };
+
+	inline PositionLength getSource( Node n ) const { return source[n]; };
+	inline void setSource( Node n, PositionLength pl ) { source[n] = pl; };
+
+	inline Node newNode( PositionLength pl ) {
+		Node n = source.size();
+
+		source.push_back( pl );
+		children_table.push_back( array<Node,4>{{ 0, 0, 0, 0 }} );
+		children_mask.push_back( 0 );
+		cluster.push_back( Cluster_invalid );
+
+		return n;
+	};
+
+	inline bool childAt( Node n0, Symbol sy, Node& n ) const {
+		if(!( children_mask[n0] & ( 1 << sy ))) {
+			return false;
+		}
+
+		Symbol pre = nu2pre[sy];
+		if( pre < 4 ) {
+			n = children_table[n0][pre];
+		} else {
+			n = children_ambig.at( symbolNode( sy, n0 ));
+		}
+
+		return true;
+	};
+
+	inline TrieChildren children( Node n0 ) const {
+		TrieChildren r;
+
+		for( unsigned short m = children_mask[n0] ; m ; m &= m-1 ) {
+			Symbol sy = __builtin_ctz( m );
+			Node n;
+			childAt( n0, sy, n );
+			r.push_back( symbolNode( sy, n ));
+		}
+
+		return r;
+	};
+
+	inline bool hasChildren( Node n0 ) const { return children_mask[n0]; };
+
+	inline void setChild( Node n0, Symbol sy, Node n ) {
+		assert( !( children_mask[n0] & ( 1 << sy )));
+
+		Symbol pre = nu2pre[sy];
+		if( pre < 4 ) {
+			children_table[n0][pre] = n;
+		} else {
+			children_ambig.emplace( symbolNode( sy, n0 ), n );
+		}
+
+		children_mask[n0] |= ( 1 << sy );
+		edges++;
+	};
+
+	inline void eraseChild( Node n0, Symbol sy ) {
+		if(!( children_mask[n0] & ( 1 << sy ))) {
+			return;
+		}
+
+		Symbol pre = nu2pre[sy];
+		if( pre < 4 ) {
+			children_table[n0][pre] = 0;
+		} else {
+			children_ambig.erase( symbolNode( sy, n0 ));
+		}
+
+		children_mask[n0] &= ~( 1 << sy );
+		edges--;
+	};
+
+	inline void eraseChildren( Node n0 ) {
+		for( SymbolNode sn: children( n0 )) {
+			eraseChild( n0, symbol( sn ));
+		}
+	};
+
+	/**
+	 * Move all children of node \param n0 under node \param n
+	 */
+	inline void moveChildren( Node n0, Node n ) {
+		for( SymbolNode sn: children( n0 )) {
+			eraseChild( n0, symbol( sn ));
+			setChild( n, symbol( sn ), node( sn ));
+		}
+	};
+
+	inline bool hasCluster( Node n ) const { return cluster[n] != Cluster_invalid; };
+	inline Cluster getCluster( Node n ) const { return cluster[n]; };
+	inline void setCluster( Node n, Cluster c ) { cluster[n] = c; };
+	inline void eraseCluster( Node n ) { cluster[n] = Cluster_invalid; };
+
+	/**
+	 * Add the storage of each array to \param m
+	 */
+	inline void memory( MemoryBreakdown& m ) const {
+		m["trie node sources"] += footprint( source );
+		m["trie children"] += footprint( children_table ) + footprint( children_ambig );
+		m["trie children masks"] += footprint( children_mask );
+		m["trie node clusters"] += footprint( cluster );
+	};
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
\ No newline at end of file
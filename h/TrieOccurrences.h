@@ -0,0 +1,278 @@
+#ifndef __TrieOccurrences_h__
+#define __TrieOccurrences_h__
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <cstring>
+
+using namespace std;
+
+#include "Types.h"
+
+/**
+ * Set of the Sequences occurring in a node of a TrieSlice
+ * 
+ * Sorted, without duplicates. Up to two Sequences are kept inline (most nodes); larger sets are
+ * sorted arrays on the heap, which switch to a bitset when that takes less storage than the array
+ * (sets dense relative to their largest Sequence, e.g. nodes shared by many sequences)
+ * 
+ * NOTE: 16 bytes per node, regardless of the number of nodes with no occurrences
+ */
+class OccurrenceSet {
+private:
+	static const unsigned int local_capacity = 2;
+	static const unsigned int bitset_flag = 1U << 31;
+	static const unsigned int word_bits = 8 * sizeof( Sequence );
+
+	unsigned int n;   // number of Sequences in the set
+	unsigned int cap; // capacity of the heap storage (Sequences, or bitset words | bitset_flag); 0 if inline
+	union {
+		Sequence  local[local_capacity];
+		Sequence* heap;
+	};
+
+public:
+	/**
+	 * Iterates over the Sequences in the set, in increasing order
+	 */
+	class const_iterator {
+	private:
+		const OccurrenceSet* o;
+		unsigned int i; // index in the array, or bit in the bitset
+
+	public:
+		typedef forward_iterator_tag iterator_category;
+		typedef Sequence value_type;
+		typedef ptrdiff_t difference_type;
+		typedef const Sequence* pointer;
+		typedef Sequence reference;
+
+		const_iterator( const OccurrenceSet* _o, unsigned int _i ): o( _o ), i( _i ) {};
+
+		inline Sequence operator* () const { return o->isBitset() ? Sequence( i ) : o->data()[i]; };
+		inline const_iterator& operator++ () {
+			i = o->isBitset() ? o->nextBit( i+1 ) : i+1;
+			return *this;
+		};
+
+		inline bool operator== ( const const_iterator& r ) const { return i == r.i; };
+		inline bool operator!= ( const const_iterator& r ) const { return i != r.i; };
+	};
+
+	OccurrenceSet(): n( 0 ), cap( 0 ) {};
+	~OccurrenceSet() { release(); };
+
+	OccurrenceSet( const OccurrenceSet& o ): n( o.n ), cap( o.cap ) {
+		if( !cap ) {
+			std::copy( o.local, o.local+local_capacity, local );
+		} else {
+			heap = new Sequence[ capacity() ];
+			std::copy( o.heap, o.heap+capacity(), heap );
+		}
+	};
+
+	OccurrenceSet( OccurrenceSet&& o ) noexcept: n( o.n ), cap( o.cap ) {
+		memcpy( local, o.local, sizeof( local )); // either representation
+		o.n = 0;
+		o.cap = 0;
+	};
+
+	OccurrenceSet& operator= ( OccurrenceSet o ) {
+		swap( n, o.n );
+		swap( cap, o.cap );
+
+		Sequence t[local_capacity];
+		memcpy( t, local, sizeof( local ));
+		memcpy( local, o.local, sizeof( local ));
+		memcpy( o.local, t, sizeof( local ));
+
+		return *this;
+	};
+
+	inline unsigned int size() const { return n; };
+	inline bool empty() const { return !n; };
+
+	inline const_iterator begin() const { return const_iterator( this, isBitset() ? nextBit( 0 ) : 0 ); };
+	inline const_iterator end() const { return const_iterator( this, isBitset() ? capacity() * word_bits : n ); };
+
+	/**
+	 * Add Sequence \param s to the set (no effect if already there)
+	 */
+	inline void insert( Sequence s ) {
+		if( isBitset()) {
+			const unsigned int w = s / word_bits;
+			if( w >= capacity()) {
+				reallocate( max( w+1, 2*capacity()), true );
+			}
+
+			const Sequence b = Sequence( 1 ) << ( s % word_bits );
+			if( !( heap[w] & b )) {
+				heap[w] |= b;
+				n++;
+			}
+			return;
+		}
+
+		Sequence* d = data();
+		Sequence* i = lower_bound( d, d+n, s );
+		if(( i != d+n ) && ( *i == s )) return; // already there
+
+		if( n == capacity()) { // full: grow, or switch to a bitset if smaller
+			const Sequence largest = max( s, n ? d[n-1] : s );
+			const unsigned int words = largest / word_bits + 1;
+
+			if(( n >= local_capacity ) && ( words <= n )) {
+				toBitset( words );
+				insert( s );
+				return;
+			}
+
+			const unsigned int at = i - d;
+			reallocate( max( 2*n, local_capacity*2 ), false );
+
+			d = data();
+			i = d + at;
+		}
+
+		move_backward( i, d+n, d+n+1 );
+		*i = s;
+		n++;
+	};
+
+	/**
+	 * Remove all Sequences from the set; releases the storage
+	 */
+	inline void clear() {
+		release();
+		n = 0;
+		cap = 0;
+	};
+
+	/**
+	 * True if the set contains only Sequence \param s (or nothing)
+	 */
+	inline bool onlyOf( Sequence s ) const {
+		return !n || (( n == 1 ) && ( *begin() == s ));
+	};
+
+	/**
+	 * \returns heap storage used by the set (bytes)
+	 */
+	inline size_t bytes() const { return cap ? capacity() * sizeof( Sequence ) : 0; };
+
+private:
+	inline bool isBitset() const { return cap & bitset_flag; };
+	inline unsigned int capacity() const { return cap ? ( cap & ~bitset_flag ) : local_capacity; };
+
+	inline Sequence* data() { return cap ? heap : local; };
+	inline const Sequence* data() const { return cap ? heap : local; };
+
+	inline void release() {
+		if( cap ) delete[] heap;
+	};
+
+	/**
+	 * First bit set in the bitset, starting with bit \param b; capacity * word_bits if none
+	 */
+	inline unsigned int nextBit( unsigned int b ) const {
+		const unsigned int words = capacity();
+
+		for( unsigned int w = b / word_bits ; w < words ; w++ ) {
+			Sequence m = heap[w];
+			if( w == b / word_bits ) m &= ~Sequence( 0 ) << ( b % word_bits );
+			if( m ) return w * word_bits + __builtin_ctz( m );
+		}
+
+		return words * word_bits;
+	};
+
+	/**
+	 * Move the content to heap storage of \param c Sequences (or bitset words if \param bits)
+	 */
+	inline void reallocate( unsigned int c, bool bits ) {
+		Sequence* h = new Sequence[c]();
+		const Sequence* d = data();
+		std::copy( d, d + ( bits ? capacity() : n ), h );
+
+		release();
+		heap = h;
+		cap = c | ( bits ? bitset_flag : 0 );
+	};
+
+	inline void toBitset( unsigned int words ) {
+		Sequence* h = new Sequence[words]();
+		const Sequence* d = data();
+		for( unsigned int i = 0 ; i < n ; i++ ) {
+			h[ d[i] / word_bits ] |= Sequence( 1 ) << ( d[i] % word_bits );
+		}
+
+		release();
+		heap = h;
+		cap = words | bitset_flag;
+	};
+};
+
+/**
+ * Occurrences of all the nodes of a TrieSlice, indexed by Node
+ */
+class TrieOccurrences {
+private:
+	vector<OccurrenceSet> occ;
+	const OccurrenceSet none; // for nodes without occurrences
+
+	inline OccurrenceSet& at( Node n ) {
+		if( n >= occ.size()) occ.resize( n+1 );
+		return occ[n];
+	};
+
+public:
+	inline const OccurrenceSet& get( Node n ) const { return ( n < occ.size()) ? occ[n] : none; };
+	inline unsigned int count( Node n ) const { return get( n ).size(); };
+
+	inline void emplace( Node n, Sequence s ) { at( n ).insert( s ); };
+	inline void erase( Node n ) { if( n < occ.size()) occ[n].clear(); };
+
+	/**
+	 * Replace the occurrences of node \param n with the ones of node \param n0
+	 */
+	inline void copy( Node n0, Node n ) {
+		at( max( n0, n )); // WARNING: may move all sets
+		occ[n] = occ[n0];
+	};
+
+	/**
+	 * Remove all occurrences; releases the storage
+	 */
+	inline void clear() { vector<OccurrenceSet>().swap( occ ); };
+
+	/**
+	 * \returns heap storage used by the occurrences of all nodes (bytes)
+	 */
+	inline size_t bytes() const {
+		size_t r = occ.capacity() * sizeof( OccurrenceSet );
+		for( const OccurrenceSet& o: occ ) r += o.bytes();
+		return r;
+	};
+};
+
+#endif
+
+// This file is part of aodp (the Automated Oligonucleotide Design Pipeline)
+// 
+// (C)	HER MAJESTY THE QUEEN IN RIGHT OF CANADA (2014-2018)
+// (C)	Manuel Zahariev mz@alumni.sfu.ca (2000-2008,2014-2018)
+// 
+// aodp is free software: you can redistribute it and/or
+// modify it under the terms of version 3 of the GNU General Public
+// License as published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License (version 3) for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// (version 3) along with this program. If not, see
+// http://www.gnu.org/licenses/.
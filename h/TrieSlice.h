@@ -19,30 +19,28 @@ using namespace std;
 #include "Source.h"
 
 #include "Trie.h"
+#include "TrieNodes.h"
+#include "TrieOccurrences.h"
 
 class TrieSlice {
+	friend class TrieIndex;
 //=======================================
 // 	DATA
 //=======================================
 private:
 	const Depth fixed_depth;
 
-	unordered_map<Node, PositionLength>  source;
-	unordered_map<SymbolNode, Node>      children_hash;
-	unordered_multimap<Node, SymbolNode> children_list;
+	TrieNodes store; // node store: sources, children and clusters
 
-	unordered_multimap<Node,Sequence>    occurrences; // temporary; removed after collect
+	TrieOccurrences occurrences; // temporary; removed after collect
 
-	unordered_map<Node, Cluster>  cluster; // id of the cluster of sequences that correspond to the node
-
-	Node next_node;
 	mutex lock;
 
 //=======================================
 // 	CODE interface
 //=======================================
 public:
-	TrieSlice( Depth depth = Trie::fixed_depth );
+	TrieSlice( Depth depth );
 
 	inline Depth getDepth() const { return fixed_depth; };
 
@@ -59,6 +57,15 @@ public:
 		lock.unlock();
 	};
 
+	/**
+	 * Add subsequence to TrieSlice, without locking
+	 * 
+	 * WARNING: the calling thread must be the only one accessing the TrieSlice (\see Trie::_cover)
+	 */
+	inline void insert( Source& src, Sequence s, Position p, Length l, Length minim ) {
+		_add( src, s, 0, p+fixed_depth, fixed_depth, l-fixed_depth, minim );
+	};
+
 	inline void mark( Source& src, Sequence s, Position p, Length l, Length minim ) {
 		lock.lock();
 		_mark( src, s, 0, p+fixed_depth, fixed_depth, l-fixed_depth, minim );
@@ -97,20 +104,26 @@ public:
 	void filterHomolo( Source& src, Depth max_homolo, Symbol sy0, Length h0, Length minim );
 
 	/**
-	 * Collect all clusters (sets of matching sequences) from all nodes in the trie slice, recursively
+	 * Intern the clusters (sets of matching sequences) of all nodes in the trie slice into \param table
+	 * and keep their provisional ids in the nodes; removes the occurrences
 	 */
-	void collectClusters( Trie& trie, Depth d );
+	void encodeClusters( ClusterTable& table );
 
 	/**
-	 * Generate a unique identifier for each Cluster
+	 * Replace the provisional cluster id of each node with the final one from \param table
 	 */
-	void encodeClusters( set<set<Sequence>>& cluster_set, Depth d, Node n ) const;
+	void collectClusters( const ClusterTable& table );
 
 	/**
 	 * Collect all matches (
 	 */
 	void collectMatches( Trie& trie, Depth d );
 
+	/**
+	 * Add the number of matches of each cluster to \param counts (indexed by cluster id)
+	 */
+	void countMatches( Trie& trie, vector<size_t>& counts );
+
 //=======================================
 // 	CODE workers
 //=======================================
@@ -139,48 +152,47 @@ private:
 	void _filterHomolo( Source& src, Depth max_homolo, Node n0, Depth d0, Symbol sy0, Length h0, Length minim );
 
 	/**
-	 * Collect all clusters (sets of matching sequences) from all nodes in the trie slice, recursively
+	 * Intern the clusters (sets of matching sequences) of all nodes in the trie slice, recursively
 	 */
-	void _collectClusters( Trie& trie, Depth d, Node n );
+	void _encodeClusters( ClusterTable& table, Node n, vector<Sequence>& l );
 
 	void _collectMatches( Trie& trie, deque<pair<Cluster,PositionDepthLength>>& m, Depth d, Node n );
+	void _countMatches( vector<Cluster>& m, Node n );
 
 //=======================================
 // 	CODE inline workers
 //=======================================
 	inline bool childAt( Node n0, Symbol sy, Node& n ) const {
-		auto pn = children_hash.find( symbolNode( sy, n0 ));
-		if( pn == children_hash.end()) {
-			return false;
-		}
-		n = pn->second;
-		return true;
+		return store.childAt( n0, sy, n );
 	};
 
-	inline vector<SymbolNode> children( Node n0 ) const {
-		vector<SymbolNode> r;
-		auto it = children_list.equal_range( n0 );
-		for( auto& c = it.first ; c != it.second ; c++ ) {
-			r.emplace_back( c->second );
-		}
-		return r;
+	inline TrieChildren children( Node n0 ) const {
+		return store.children( n0 );
 	};
 
-	inline vector<Sequence> occ( Node n0 ) const {
-		vector<Sequence> r;
-		auto it = occurrences.equal_range( n0 );
-		for( auto& c = it.first ; c != it.second ; c++ ) {
-			r.emplace_back( c->second );
-		}
-		return r;
+	inline const OccurrenceSet& occ( Node n0 ) const {
+		return occurrences.get( n0 );
 	};
 
 	inline Node newChild( Node n0, Symbol sy, Position p, Length l ) {
-		Node n = next_node++;
+		Node n = store.newNode( positionLength( p, l ));
+		store.setChild( n0, sy, n );
 
-		source.emplace( n, positionLength( p, l ));
-		children_hash.emplace( symbolNode( sy, n0 ), n );
-		children_list.emplace( n0, symbolNode( sy, n ));
+		return n;
+	};
+
+	/**
+	 * Insert a new node between node \param n0 and all its children
+	 *
+	 * The new node becomes the only child (with symbol \param sy) of \param n0
+	 * and inherits all of its children.
+	 *
+	 * \return new node
+	 */
+	inline Node insertChild( Node n0, Symbol sy, Position p, Length l ) {
+		Node n = store.newNode( positionLength( p, l ));
+		store.moveChildren( n0, n );
+		store.setChild( n0, sy, n );
 
 		return n;
 	};
@@ -195,29 +207,18 @@ private:
 	 * \return new node
 	 */
 	inline Node splitNode( Node n0, Symbol sy, Length l ) {
-		PositionLength pl0 = source.at( n0 );
+		PositionLength pl0 = store.getSource( n0 );
 		Position p0 = position( pl0 );
 		Length l0 = length( pl0 );
 
 		assert( l  > 0 );
 		assert( l0 > l );
 
-		vector<SymbolNode> ch = children( n0 );
-		vector<Sequence>   oc = occ( n0 );
-
-		source.at( n0 ) = positionLength( p0, l );
+		store.setSource( n0, positionLength( p0, l ));
 
-		eraseChildren( n0 );
-		Node n1 = newChild( n0, sy, p0+l, l0-l );
+		Node n1 = insertChild( n0, sy, p0+l, l0-l );
 
-		for( SymbolNode sn: ch ) {
-			children_list.emplace( n1, sn );
-			children_hash.emplace( symbolNode( symbol( sn ), n1 ), node( sn ));
-		}
-
-		for( Sequence s: oc ) {
-			occurrences.emplace( n1, s );
-		}
+		occurrences.copy( n0, n1 );
 
 		return n1;
 	}
@@ -225,44 +226,24 @@ private:
 	/**
 	 * Erase a child with symbol \param sy of node \param n0
 	 * 
-	 * Only the navigation elements in the children_* maps are erased:
+	 * Only the navigation elements are erased:
 	 * the payload remains, but is inaccessible
 	 * 
 	 * TODO: erase descendents
 	 */
 	inline void eraseChild( Node n0, Symbol sy ) {
-		children_hash.erase( symbolNode( sy, n0 ));
-
-// 	ch is a pair<iterator_first, iterator_past_last>
-		auto ch = children_list.equal_range( n0 );
-// 	c is a pair<Node,SymbolNode>
-		for( auto c=ch.first ; c!=ch.second ; c++ ) {
-			if( symbol( c->second ) == sy ) {
-				auto n=c;
-// 	n is the next element after the child to be erased
-				children_list.erase( c, ++n );
-// 	At this point, the job is done; Leave now!
-// 	WARNING: the iterators are invalidated after "erase"
-				return;
-			}
-		}
+		store.eraseChild( n0, sy );
 	};
 	/**
 	 * Erase all children of node \param n0
 	 * 
-	 * Only the navigation elements in the children_* maps are erased:
+	 * Only the navigation elements are erased:
 	 * the payload remains, but is inaccessible
 	 * 
 	 * TODO: erase descendents
 	 */
 	inline void eraseChildren( Node n0 ) {
-// 	ch is a pair<iterator_first, iterator_past_last>
-		auto ch = children_list.equal_range( n0 );
-// 	c is a pair<Node,SymbolNode>
-		for( auto c=ch.first ; c!=ch.second ; c++ ) {
-			children_hash.erase( symbolNode( symbol( c->second ), n0 ));
-		}
-		children_list.erase( n0 );
+		store.eraseChildren( n0 );
 	};
 
 	/**
@@ -272,14 +253,8 @@ private:
 	 * with a small difference occurs in the same sequence.
 	 */
 	inline void eraseOccurrencesUnlessOwn( Node n0, Sequence s ) {
-		auto r = occurrences.equal_range( n0 );
-
-		for( auto se = r.first ; se != r.second ; se++ ) {
-			if( se->second != s ) {
-				occurrences.erase( n0 );
-// 	WARNING: invalidates the iterator; don't do anything more with it!
-				return;
-			}
+		if( !occ( n0 ).onlyOf( s )) {
+			occurrences.erase( n0 );
 		}
 	};
 
@@ -294,11 +269,16 @@ public:
 		Distribution& depth_distribution, Distribution& length_distribution, Distribution& occurrence_distribution
 	) const;
 
+	inline void memory( MemoryBreakdown& m ) const {
+		store.memory( m );
+		m["trie occurrences"] += occurrences.bytes();
+	};
+
 	void print( const Source& src, Node n, Depth d, string root="" ) const;
 	string getNodeSource( Source& src, Node n0, Node n, Depth d=0 ) const;
 	void verify( const Source& src, Node n ) const;
 
-	inline Node size() const { return children_hash.size(); };
+	inline Node size() const { return store.size(); };
 
 	unordered_multimap<string,Sequence>& find( const Source& so, const string& s, unordered_multimap<string,Sequence>& a ) const;
 	unordered_multimap<string,Sequence>& find( const Source& so, const string& s, Node n0, Depth d, unordered_multimap<string,Sequence>& a ) const;
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <array>
 #include <bitset>
 #include <map>
 #include <algorithm>
@@ -41,13 +42,13 @@ const Cluster Cluster_invalid = numeric_limits<Cluster>::max();
 /**
  * Index in the array (deque) of Trie Slices
  */
-typedef unsigned short Slice;
+typedef unsigned int Slice;
 /**
- * Encoded 4-base subsequence prefix; used to calculate the slice corresponding to a subsequence
+ * Encoded subsequence prefix (4 bits per base); used to calculate the slice corresponding to a subsequence
  * 
- * WARNING: fixed length
+ * WARNING: supports prefixes of up to 8 bases
  */
-typedef unsigned short Prefix4;
+typedef unsigned int Prefix;
 
 // TODO: generate exception for nodes over limit (LOW)
 // WARNING:	Supports up to 2^(32-4) = 2^28 = 268,435,456 nodes
@@ -426,75 +427,65 @@ inline Length maxHomolo( const string& s ) {
 }
 
 /**
- * Create a 4-base prefix from four unambiguous nucleotides
- */
-inline Prefix4 nu2p4( const Symbol n1, const Symbol n2, const Symbol n3, const Symbol n4 ) {
-	assert( !nu2ambig.at( n1 ));
-	assert( !nu2ambig.at( n2 ));
-	assert( !nu2ambig.at( n3 ));
-	assert( !nu2ambig.at( n4 ));
-
-	Prefix4 r = n1 & 0xF;
-	r <<= 4;
-	r |= ( n2 & 0xF );
-	r <<= 4;
-	r |= ( n3 & 0xF );
-	r <<= 4;
-	r |= ( n4 & 0xF );
-
-	return r;
-};
-
-/**
- * Convert a 4-base prefix starting at position \param p in string \param s to an encoded prefix
+ * Convert a \param d-base prefix starting at position \param p in string \param s to an encoded prefix
+ * 
+ * NOTE: \param s is any string of 4-bit nucleotides (e.g. string, PackedSequence)
  */
-inline Prefix4 nu2p4( const string& s, Position p ) {
-	assert( s.size() >= p+4 );
+template<class S> inline Prefix nu2pr( const S& s, Position p, Depth d ) {
+	assert( s.size() >= p+d );
 
-	Prefix4 r = s.at( p ) & 0xF;
-	r <<= 4;
-	r |= ( s.at( p+1 ) & 0xF );
-	r <<= 4;
-	r |= ( s.at( p+2 ) & 0xF );
-	r <<= 4;
-	r |= ( s.at( p+3 ) & 0xF );
+	Prefix r = 0;
+	for( Depth i = 0 ; i < d ; i++ ) {
+		r <<= 4;
+		r |= ( s[p+i] & 0xF );
+	}
 
 	return r;
 };
 
 /**
- * Convert an encoded prefix to a 4-base prefix string
+ * Convert an encoded \param d-base prefix to a prefix string
  * 
  * \return reference to shared storage; will be overwritten by subsequent calls (WARNING)
  */
-inline const string& p42nu( const Prefix4& pr ) {
- 	thread_local string s = "    ";
+inline const string& pr2nu( const Prefix& pr, Depth d ) {
+ 	thread_local string s;
 
-	s.at( 3 ) = pr     & 0xF;
-	s.at( 2 ) = pr>>4  & 0xF;
-	s.at( 1 ) = pr>>8  & 0xF;
-	s.at( 0 ) = pr>>12 & 0xF;
+	s.resize( d );
+	for( Depth i = 0 ; i < d ; i++ ) {
+		s.at( d-1-i ) = pr >> ( 4*i ) & 0xF;
+	}
 
 	return s;
 };
 
 /**
- * Number of matches between two encoded prefixes
+ * Number of matches between two encoded \param d-base prefixes
  */
-inline Length p4ma( const Prefix4& pr1, const Prefix4& pr2 ) {
-	Prefix4 m = pr1 & pr2;
-	return !!( m & 0x000F ) + !!( m & 0x00F0 ) + !!( m & 0x0F00 ) + !!( m & 0xF000 );
+inline Length prma( const Prefix& pr1, const Prefix& pr2, Depth d ) {
+	Prefix m = pr1 & pr2;
+
+	Length r = 0;
+	for( Depth i = 0 ; i < d ; i++ ) {
+		r += !!( m >> ( 4*i ) & 0xF );
+	}
+
+	return r;
 };
 
-inline pair<Length,Symbol> p4ho( const Prefix4& pr ) {
+/**
+ * Length and symbol of the homologous section at the end of an encoded \param d-base prefix
+ */
+inline pair<Length,Symbol> prho( const Prefix& pr, Depth d ) {
 	Symbol sy = pr & 0xF;
-	if( nu2ambig.at( sy ))     { return pair<Length,Symbol>{ 0, 0 };  } // ambiguous last symbol; no start of a homologous section
+	if( nu2ambig.at( sy )) { return pair<Length,Symbol>{ 0, 0 }; } // ambiguous last symbol; no start of a homologous section
 
-	if( sy != ( pr>>4  & 0xF )) { return pair<Length,Symbol>{ 1, sy }; } // one 
-	if( sy != ( pr>>8  & 0xF )) { return pair<Length,Symbol>{ 2, sy }; } // two
-	if( sy != ( pr>>12 & 0xF )) { return pair<Length,Symbol>{ 3, sy }; } // three
-	                              return pair<Length,Symbol>{ 4, sy };   // four
+	Length l = 1;
+	while(( l < d ) && ( sy == ( pr >> ( 4*l ) & 0xF ))) {
+		l++;
+	}
 
+	return pair<Length,Symbol>{ l, sy };
 };
 
 #endif
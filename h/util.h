@@ -15,9 +15,8 @@
 #include <sys/stat.h>
 #include <wordexp.h>
 
-#include <thread>
-
 #include "Error.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
@@ -310,37 +309,6 @@ template<typename T> inline bool contains( const set<T>& a, const set<T>& b )
 	return includes( a.begin(), a.end(), b.begin(), b.end());
 }
 
-/**
- * Start and wait for the finishing of \param t threads, using function \param f of object \param o
- * and passing to each the parameter list \param args
- * 
- * Each thread function is responsible with managing its own workload (e.g. using static static variables)
- * and not interfering with other threds (e.g. using mutexes)
- * 
- * Each thread function expects a boolean parameter ("first") that indicates whether this is the first
- * thread in the pool (to support "unique initialization
- * 
- * WARNING: derived functors cannot be passed as parameters
- */
-template<class C, typename... Args>
-void spin( unsigned int t, C& o, void ( C::* f )( bool&, Args&... ), Args&... args ) {
-	vector<thread> v;  // thread pool
-	static bool first; // shared flag indicating whether this is the first thread executing
-
-	first = true;
-
-	for( unsigned int i=0 ; i<t ; i++ ){ // start all threads
-// 	equivalent to thread t( f, &o, ref( first ), args... );
-		v.emplace_back( f, &o, ref( first ), args... );
-// 	NOTE: "first" must be passed by reference, so that "unique initialization" can be shared by all spinned threads
-	}
-
-	for( thread& th: v ){ // wait for all threads to finish
-		th.join();
-	}
-};
-
-
 // TEST
 template<typename T> ostream& operator<< ( ostream& o, const set<T>& s )
 {